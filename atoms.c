@@ -0,0 +1,205 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <xcb/xcb.h>
+
+#include "nwm.h"
+#include "atoms.h"
+
+xcb_atom_t atoms[ATOM_COUNT];
+
+static const char *atom_names[ATOM_COUNT] = {
+    "WM_PROTOCOLS",
+    "WM_DELETE_WINDOW",
+    "WM_TAKE_FOCUS",
+    "WM_STATE",
+    "WM_CHANGE_STATE",
+    "WM_CLIENT_LEADER",
+    "WM_WINDOW_ROLE",
+    "UTF8_STRING",
+    "_NET_SUPPORTED",
+    "_NET_SUPPORTING_WM_CHECK",
+    "_NET_CLIENT_LIST",
+    "_NET_CLIENT_LIST_STACKING",
+    "_NET_ACTIVE_WINDOW",
+    "_NET_CLOSE_WINDOW",
+    "_NET_NUMBER_OF_DESKTOPS",
+    "_NET_CURRENT_DESKTOP",
+    "_NET_DESKTOP_NAMES",
+    "_NET_WM_DESKTOP",
+    "_NET_WM_NAME",
+    "_NET_WM_VISIBLE_NAME",
+    "_NET_WM_PID",
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_DEMANDS_ATTENTION",
+    "_NET_WM_WINDOW_TYPE",
+    "_NET_WM_WINDOW_TYPE_NORMAL",
+    "_NET_WM_WINDOW_TYPE_DIALOG",
+    "_NET_WM_WINDOW_TYPE_DOCK",
+    "_NET_WM_WINDOW_TYPE_SPLASH",
+    "_NET_WM_WINDOW_TYPE_UTILITY",
+    "_NET_WM_WINDOW_TYPE_TOOLBAR",
+    "_NET_WM_STRUT",
+    "_NET_WM_STRUT_PARTIAL",
+    "_NET_FRAME_EXTENTS",
+};
+
+/* Every atom we have interned, by name.  Open addressing with linear
+ * probing; atoms are never forgotten, so there is no removal.
+ */
+typedef struct atom_entry {
+    char *name;
+    xcb_atom_t atom;
+} atom_entry_t;
+
+#define INITIAL_BITS 7
+
+static atom_entry_t *table = NULL;
+static unsigned int table_bits = 0;
+static unsigned int table_used = 0;
+
+#define TABLE_SIZE (1u << table_bits)
+#define TABLE_MASK (TABLE_SIZE - 1)
+
+/* FNV-1a */
+static unsigned int slot_for(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (; *name; ++name)
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    return hash & TABLE_MASK;
+}
+
+static void table_alloc(unsigned int bits)
+{
+    table_bits = bits;
+    table_used = 0;
+    table = (atom_entry_t *)calloc(TABLE_SIZE, sizeof(atom_entry_t));
+    if (!table) {
+        perror("atom table allocation failed");
+        exit(1);
+    }
+}
+
+/* Takes ownership of name */
+static void table_insert(char *name, xcb_atom_t atom)
+{
+    unsigned int i = slot_for(name);
+
+    while (table[i].name && strcmp(table[i].name, name) != 0)
+        i = (i + 1) & TABLE_MASK;
+    if (table[i].name)
+        free(table[i].name);
+    else
+        ++table_used;
+    table[i].name = name;
+    table[i].atom = atom;
+}
+
+static void table_grow(void)
+{
+    atom_entry_t *old = table;
+    unsigned int old_size = (old ? TABLE_SIZE : 0);
+    unsigned int i;
+
+    table_alloc(old ? table_bits + 1 : INITIAL_BITS);
+    for (i = 0; i < old_size; ++i) {
+        if (old[i].name)
+            table_insert(old[i].name, old[i].atom);
+    }
+    free(old);
+}
+
+static void table_add(const char *name, xcb_atom_t atom)
+{
+    /* keep the load factor at or below one half */
+    if (!table || (table_used + 1) * 2 > TABLE_SIZE)
+        table_grow();
+    table_insert(strdup(name), atom);
+}
+
+static atom_entry_t *table_find(const char *name)
+{
+    unsigned int i;
+
+    if (!table)
+        return NULL;
+    for (i = slot_for(name); table[i].name; i = (i + 1) & TABLE_MASK) {
+        if (strcmp(table[i].name, name) == 0)
+            return &table[i];
+    }
+    return NULL;
+}
+
+/* Intern all the atoms in atom_names.  The requests all go out before
+ * the first reply is read, so this costs one round trip in total.
+ */
+void atoms_init(void)
+{
+    xcb_intern_atom_cookie_t cookies[ATOM_COUNT];
+    xcb_intern_atom_reply_t *reply;
+    int i;
+
+    for (i = 0; i < ATOM_COUNT; ++i)
+        cookies[i] = xcb_intern_atom(wm_conf.connection, 0, strlen(atom_names[i]),
+                                     atom_names[i]);
+    for (i = 0; i < ATOM_COUNT; ++i) {
+        reply = xcb_intern_atom_reply(wm_conf.connection, cookies[i], NULL);
+        if (!reply) {
+            fprintf(stderr, "failed to intern atom %s\n", atom_names[i]);
+            atoms[i] = XCB_NONE;
+            continue;
+        }
+        atoms[i] = reply->atom;
+        table_add(atom_names[i], reply->atom);
+        free(reply);
+    }
+    ++wm_conf.round_trips;
+}
+
+/* The atom for name, interning it (and waiting for the server) only
+ * the first time it is asked for.  Returns XCB_NONE on failure.
+ */
+xcb_atom_t atoms_intern(const char *name)
+{
+    atom_entry_t *entry = table_find(name);
+    xcb_intern_atom_cookie_t cookie;
+    xcb_intern_atom_reply_t *reply;
+    xcb_atom_t atom;
+
+    if (entry)
+        return entry->atom;
+
+    cookie = xcb_intern_atom(wm_conf.connection, 0, strlen(name), name);
+    reply = xcb_intern_atom_reply(wm_conf.connection, cookie, NULL);
+    ++wm_conf.round_trips;
+    if (!reply)
+        return XCB_NONE;
+    atom = reply->atom;
+    free(reply);
+    table_add(name, atom);
+    return atom;
+}
@@ -0,0 +1,75 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __ATOMS_H__
+#define __ATOMS_H__
+
+#include <xcb/xcb.h>
+
+/* Atoms interned in one batch at startup.  Keep this in the same order
+ * as atom_names in atoms.c.
+ */
+enum atom_id {
+    /* ICCCM */
+    ATOM_WM_PROTOCOLS,
+    ATOM_WM_DELETE_WINDOW,
+    ATOM_WM_TAKE_FOCUS,
+    ATOM_WM_STATE,
+    ATOM_WM_CHANGE_STATE,
+    ATOM_WM_CLIENT_LEADER,
+    ATOM_WM_WINDOW_ROLE,
+    ATOM_UTF8_STRING,
+    /* EWMH */
+    ATOM_NET_SUPPORTED,
+    ATOM_NET_SUPPORTING_WM_CHECK,
+    ATOM_NET_CLIENT_LIST,
+    ATOM_NET_CLIENT_LIST_STACKING,
+    ATOM_NET_ACTIVE_WINDOW,
+    ATOM_NET_CLOSE_WINDOW,
+    ATOM_NET_NUMBER_OF_DESKTOPS,
+    ATOM_NET_CURRENT_DESKTOP,
+    ATOM_NET_DESKTOP_NAMES,
+    ATOM_NET_WM_DESKTOP,
+    ATOM_NET_WM_NAME,
+    ATOM_NET_WM_VISIBLE_NAME,
+    ATOM_NET_WM_PID,
+    ATOM_NET_WM_STATE,
+    ATOM_NET_WM_STATE_FULLSCREEN,
+    ATOM_NET_WM_STATE_HIDDEN,
+    ATOM_NET_WM_STATE_DEMANDS_ATTENTION,
+    ATOM_NET_WM_WINDOW_TYPE,
+    ATOM_NET_WM_WINDOW_TYPE_NORMAL,
+    ATOM_NET_WM_WINDOW_TYPE_DIALOG,
+    ATOM_NET_WM_WINDOW_TYPE_DOCK,
+    ATOM_NET_WM_WINDOW_TYPE_SPLASH,
+    ATOM_NET_WM_WINDOW_TYPE_UTILITY,
+    ATOM_NET_WM_WINDOW_TYPE_TOOLBAR,
+    ATOM_NET_WM_STRUT,
+    ATOM_NET_WM_STRUT_PARTIAL,
+    ATOM_NET_FRAME_EXTENTS,
+    ATOM_COUNT
+};
+
+extern xcb_atom_t atoms[ATOM_COUNT];
+
+void atoms_init(void);
+xcb_atom_t atoms_intern(const char *);
+
+#endif
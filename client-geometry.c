@@ -0,0 +1,234 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <xcb/xcb.h>
+
+#include "nwm.h"
+#include "client-geometry.h"
+
+/* One of these per geometry value: what layouts asked for, and what
+ * the server was last told (or told us).
+ */
+typedef struct geometry_table {
+    int16_t *x;
+    int16_t *y;
+    uint16_t *width;
+    uint16_t *height;
+    uint16_t *border_width;
+} geometry_table_t;
+
+static geometry_table_t desired;
+static geometry_table_t applied;
+/* the client in each slot, NULL for free slots */
+static client_t **owner = NULL;
+/* whether applied holds anything yet */
+static bool *applied_valid = NULL;
+/* scratch space for client_geometry_commit */
+static client_t **changed_list = NULL;
+
+static uint32_t table_cap = 0;
+/* one past the highest slot ever attached, the end of the commit scan */
+static uint32_t table_end = 0;
+static bool dirty = false;
+
+static void *grow_array(void *array, size_t elem_size, uint32_t old_cap, uint32_t new_cap)
+{
+    char *grown = (char *)realloc(array, new_cap * elem_size);
+    if (!grown) {
+        perror("client geometry allocation failed");
+        exit(1);
+    }
+    memset(grown + old_cap * elem_size, 0, (new_cap - old_cap) * elem_size);
+    return grown;
+}
+
+static void grow_table(geometry_table_t *table, uint32_t old_cap, uint32_t new_cap)
+{
+    table->x = grow_array(table->x, sizeof(int16_t), old_cap, new_cap);
+    table->y = grow_array(table->y, sizeof(int16_t), old_cap, new_cap);
+    table->width = grow_array(table->width, sizeof(uint16_t), old_cap, new_cap);
+    table->height = grow_array(table->height, sizeof(uint16_t), old_cap, new_cap);
+    table->border_width = grow_array(table->border_width, sizeof(uint16_t), old_cap, new_cap);
+}
+
+static void reserve_slot(uint32_t slot)
+{
+    uint32_t new_cap = (table_cap ? table_cap : 64);
+
+    if (slot < table_cap)
+        return;
+    while (slot >= new_cap)
+        new_cap *= 2;
+    grow_table(&desired, table_cap, new_cap);
+    grow_table(&applied, table_cap, new_cap);
+    owner = grow_array(owner, sizeof(client_t *), table_cap, new_cap);
+    applied_valid = grow_array(applied_valid, sizeof(bool), table_cap, new_cap);
+    changed_list = grow_array(changed_list, sizeof(client_t *), table_cap, new_cap);
+    table_cap = new_cap;
+}
+
+/* Give a new client a zeroed row, with nothing applied yet */
+void client_geometry_attach(client_t *client)
+{
+    uint32_t slot = client->slot;
+
+    reserve_slot(slot);
+    desired.x[slot] = desired.y[slot] = 0;
+    desired.width[slot] = desired.height[slot] = desired.border_width[slot] = 0;
+    owner[slot] = client;
+    applied_valid[slot] = false;
+    if (slot >= table_end)
+        table_end = slot + 1;
+}
+
+void client_geometry_detach(client_t *client)
+{
+    owner[client->slot] = NULL;
+}
+
+rect_t client_geometry_rect(client_t *client)
+{
+    uint32_t slot = client->slot;
+    rect_t rect = { desired.x[slot], desired.y[slot],
+                    desired.width[slot], desired.height[slot] };
+    return rect;
+}
+
+uint16_t client_geometry_border_width(client_t *client)
+{
+    return desired.border_width[client->slot];
+}
+
+void client_geometry_set_position(client_t *client, int16_t x, int16_t y)
+{
+    desired.x[client->slot] = x;
+    desired.y[client->slot] = y;
+    dirty = true;
+}
+
+void client_geometry_set_size(client_t *client, uint16_t width, uint16_t height)
+{
+    desired.width[client->slot] = width;
+    desired.height[client->slot] = height;
+    dirty = true;
+}
+
+void client_geometry_set_border_width(client_t *client, uint16_t border_width)
+{
+    desired.border_width[client->slot] = border_width;
+    dirty = true;
+}
+
+/* Record geometry the server reported.  It becomes the desired
+ * geometry as well, so nothing is sent back for it.
+ */
+void client_geometry_set_applied(client_t *client, const rect_t *rect, uint16_t border_width)
+{
+    uint32_t slot = client->slot;
+
+    desired.x[slot] = applied.x[slot] = rect->x;
+    desired.y[slot] = applied.y[slot] = rect->y;
+    desired.width[slot] = applied.width[slot] = rect->width;
+    desired.height[slot] = applied.height[slot] = rect->height;
+    desired.border_width[slot] = applied.border_width[slot] = border_width;
+    applied_valid[slot] = true;
+}
+
+/* Forget what the server was told, so the whole desired geometry is
+ * sent again on the next commit.
+ */
+void client_geometry_invalidate(client_t *client)
+{
+    applied_valid[client->slot] = false;
+    dirty = true;
+}
+
+bool client_geometry_pending(void)
+{
+    return dirty;
+}
+
+/* Send a ConfigureWindow for every client whose desired geometry
+ * differs from what was applied, with only the changed values, then
+ * call changed (if given) for each of them.  Returns the number of
+ * clients configured.
+ */
+int client_geometry_commit(xcb_connection_t *c, client_geometry_func changed)
+{
+    uint32_t slot, values[5];
+    uint16_t mask;
+    int n, count = 0;
+
+    if (!dirty)
+        return 0;
+    dirty = false;
+
+    for (slot = 0; slot < table_end; ++slot) {
+        if (!owner[slot])
+            continue;
+
+        mask = 0;
+        n = 0;
+        if (!applied_valid[slot] || desired.x[slot] != applied.x[slot]) {
+            mask |= XCB_CONFIG_WINDOW_X;
+            values[n++] = (uint32_t)(int32_t)desired.x[slot];
+        }
+        if (!applied_valid[slot] || desired.y[slot] != applied.y[slot]) {
+            mask |= XCB_CONFIG_WINDOW_Y;
+            values[n++] = (uint32_t)(int32_t)desired.y[slot];
+        }
+        if (!applied_valid[slot] || desired.width[slot] != applied.width[slot]) {
+            mask |= XCB_CONFIG_WINDOW_WIDTH;
+            values[n++] = desired.width[slot];
+        }
+        if (!applied_valid[slot] || desired.height[slot] != applied.height[slot]) {
+            mask |= XCB_CONFIG_WINDOW_HEIGHT;
+            values[n++] = desired.height[slot];
+        }
+        if (!applied_valid[slot] || desired.border_width[slot] != applied.border_width[slot]) {
+            mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH;
+            values[n++] = desired.border_width[slot];
+        }
+        if (!mask)
+            continue;
+
+        xcb_configure_window(c, owner[slot]->window, mask, values);
+        applied.x[slot] = desired.x[slot];
+        applied.y[slot] = desired.y[slot];
+        applied.width[slot] = desired.width[slot];
+        applied.height[slot] = desired.height[slot];
+        applied.border_width[slot] = desired.border_width[slot];
+        applied_valid[slot] = true;
+        changed_list[count++] = owner[slot];
+    }
+
+    /* the callbacks may move clients again, or unmanage them, so they
+     * only run once the scan is over */
+    if (changed) {
+        for (n = 0; n < count; ++n) {
+            if (owner[changed_list[n]->slot] == changed_list[n])
+                changed(changed_list[n]);
+        }
+    }
+    return count;
+}
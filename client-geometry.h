@@ -0,0 +1,51 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __CLIENT_GEOMETRY_H__
+#define __CLIENT_GEOMETRY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "nwm.h"
+
+/* Client geometry, kept out of client_t in parallel arrays indexed by
+ * client pool slot.  Layouts only change the desired geometry; once a
+ * cycle client_geometry_commit() compares it with what was last sent
+ * to the server and configures just the windows, and just the values,
+ * that changed.
+ */
+
+typedef void (*client_geometry_func)(client_t *);
+
+void client_geometry_attach(client_t *);
+void client_geometry_detach(client_t *);
+rect_t client_geometry_rect(client_t *);
+uint16_t client_geometry_border_width(client_t *);
+void client_geometry_set_position(client_t *, int16_t, int16_t);
+void client_geometry_set_size(client_t *, uint16_t, uint16_t);
+void client_geometry_set_border_width(client_t *, uint16_t);
+void client_geometry_set_applied(client_t *, const rect_t *, uint16_t);
+void client_geometry_invalidate(client_t *);
+bool client_geometry_pending(void);
+int client_geometry_commit(xcb_connection_t *, client_geometry_func);
+
+#endif
@@ -0,0 +1,136 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "client-index.h"
+
+/* Open addressing with linear probing.  XCB_NONE marks an empty slot;
+ * removal shifts later entries of the same run back instead of leaving
+ * tombstones, so lookups never have to skip over dead entries.
+ */
+typedef struct index_entry {
+    xcb_window_t window;
+    struct client *client;
+} index_entry_t;
+
+#define INITIAL_BITS 6
+
+static index_entry_t *table = NULL;
+static unsigned int table_bits = 0;
+static unsigned int table_used = 0;
+
+#define TABLE_SIZE (1u << table_bits)
+#define TABLE_MASK (TABLE_SIZE - 1)
+
+/* Window ids are handed out sequentially per X client, so spread them
+ * with a multiplicative (Fibonacci) hash rather than using the low bits.
+ */
+static unsigned int slot_for(xcb_window_t window)
+{
+    return (uint32_t)(window * 2654435769u) >> (32 - table_bits);
+}
+
+static void table_alloc(unsigned int bits)
+{
+    table_bits = bits;
+    table_used = 0;
+    table = (index_entry_t *)calloc(TABLE_SIZE, sizeof(index_entry_t));
+    if (!table) {
+        perror("client index allocation failed");
+        exit(1);
+    }
+}
+
+static void table_insert(xcb_window_t window, struct client *client)
+{
+    unsigned int i = slot_for(window);
+
+    while (table[i].window != XCB_NONE && table[i].window != window)
+        i = (i + 1) & TABLE_MASK;
+    if (table[i].window == XCB_NONE)
+        ++table_used;
+    table[i].window = window;
+    table[i].client = client;
+}
+
+static void table_grow(void)
+{
+    index_entry_t *old = table;
+    unsigned int old_size = (old ? TABLE_SIZE : 0);
+    unsigned int i;
+
+    table_alloc(old ? table_bits + 1 : INITIAL_BITS);
+    for (i = 0; i < old_size; ++i) {
+        if (old[i].window != XCB_NONE)
+            table_insert(old[i].window, old[i].client);
+    }
+    free(old);
+}
+
+/* Point window at client, replacing whatever it pointed at before */
+void client_index_set(xcb_window_t window, struct client *client)
+{
+    /* keep the load factor at or below one half */
+    if (!table || (table_used + 1) * 2 > TABLE_SIZE)
+        table_grow();
+    table_insert(window, client);
+}
+
+void client_index_remove(xcb_window_t window)
+{
+    unsigned int i, j, home;
+
+    if (!table)
+        return;
+    for (i = slot_for(window); table[i].window != window; i = (i + 1) & TABLE_MASK) {
+        if (table[i].window == XCB_NONE)
+            return;
+    }
+
+    /* close the gap: move back any later entry of this run whose home
+     * slot isn't between the gap and itself */
+    for (j = (i + 1) & TABLE_MASK; table[j].window != XCB_NONE; j = (j + 1) & TABLE_MASK) {
+        home = slot_for(table[j].window);
+        if (((j - home) & TABLE_MASK) >= ((j - i) & TABLE_MASK)) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i].window = XCB_NONE;
+    table[i].client = NULL;
+    --table_used;
+}
+
+struct client *client_index_find(xcb_window_t window)
+{
+    unsigned int i;
+
+    if (!table || window == XCB_NONE)
+        return NULL;
+    for (i = slot_for(window); table[i].window != XCB_NONE; i = (i + 1) & TABLE_MASK) {
+        if (table[i].window == window)
+            return table[i].client;
+    }
+    return NULL;
+}
@@ -0,0 +1,36 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __CLIENT_INDEX_H__
+#define __CLIENT_INDEX_H__
+
+#include <xcb/xcb.h>
+
+/* An index from window to client, kept alongside client_list so
+ * lookups by window don't have to walk the list.
+ */
+
+struct client;
+
+void client_index_set(xcb_window_t, struct client *);
+void client_index_remove(xcb_window_t);
+struct client *client_index_find(xcb_window_t);
+
+#endif
@@ -0,0 +1,108 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <libguile.h>
+
+#include "nwm.h"
+#include "client-pool.h"
+
+/* clients per slab */
+#define CLIENT_SLAB_SIZE 64
+
+static client_t **slabs = NULL;
+static uint32_t slabs_len = 0;
+static uint32_t slabs_cap = 0;
+
+/* free clients, linked through their next pointers */
+static client_t *free_list = NULL;
+
+static void add_slab(void)
+{
+    client_t *slab;
+    int i;
+
+    if (slabs_len == slabs_cap) {
+        slabs_cap = (slabs_cap ? slabs_cap * 2 : 16);
+        slabs = (client_t **)realloc(slabs, slabs_cap * sizeof(client_t *));
+        if (!slabs) {
+            perror("client pool allocation failed");
+            exit(1);
+        }
+    }
+    slab = (client_t *)calloc(CLIENT_SLAB_SIZE, sizeof(client_t));
+    if (!slab) {
+        perror("client pool allocation failed");
+        exit(1);
+    }
+
+    /* push in reverse so the lowest slots are handed out first */
+    for (i = CLIENT_SLAB_SIZE - 1; i >= 0; --i) {
+        slab[i].slot = slabs_len * CLIENT_SLAB_SIZE + i;
+        slab[i].generation = 1;
+        slab[i].next = free_list;
+        free_list = &slab[i];
+    }
+    slabs[slabs_len++] = slab;
+}
+
+/* A zeroed client, apart from its slot and generation */
+client_t *client_pool_alloc(void)
+{
+    client_t *client;
+    uint32_t slot, generation;
+
+    if (!free_list)
+        add_slab();
+    client = free_list;
+    free_list = client->next;
+
+    slot = client->slot;
+    generation = client->generation;
+    memset(client, 0, sizeof(client_t));
+    client->slot = slot;
+    client->generation = generation;
+    client->smob = SCM_BOOL_F;
+    return client;
+}
+
+void client_pool_free(client_t *client)
+{
+    /* whatever still refers to the old generation now finds nothing;
+     * zero is never a valid generation */
+    if (++client->generation == 0)
+        client->generation = 1;
+    client->window = XCB_NONE;
+    client->next = free_list;
+    free_list = client;
+}
+
+/* The client in the given slot, if it is still the given generation */
+client_t *client_pool_get(uint32_t slot, uint32_t generation)
+{
+    client_t *client;
+
+    if (slot >= slabs_len * CLIENT_SLAB_SIZE)
+        return NULL;
+    client = &slabs[slot / CLIENT_SLAB_SIZE][slot % CLIENT_SLAB_SIZE];
+    return (client->generation == generation ? client : NULL);
+}
@@ -0,0 +1,39 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __CLIENT_POOL_H__
+#define __CLIENT_POOL_H__
+
+#include <stdint.h>
+
+/* Client structures live in fixed-size slabs and are never returned to
+ * malloc: a freed client's slot goes back on a free list for the next
+ * window.  Every slot has a generation, bumped when it is freed, so a
+ * (slot, generation) pair kept elsewhere (in a Scheme smob, say) can
+ * tell whether it still names the same client.
+ */
+
+struct client;
+
+struct client *client_pool_alloc(void);
+void client_pool_free(struct client *);
+struct client *client_pool_get(uint32_t, uint32_t);
+
+#endif
@@ -0,0 +1,232 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <xcb/xcb.h>
+#include <xcb/xcb_icccm.h>
+
+#include "nwm.h"
+#include "client-props.h"
+#include "reply-queue.h"
+#include "atoms.h"
+
+/* longest name or class we keep, in 32-bit units as GetProperty wants */
+#define MAX_TEXT_LENGTH 256
+#define MAX_PROTOCOLS 32
+
+/* What a property reply needs to find its way back */
+typedef struct prop_request {
+    xcb_window_t window;
+    unsigned int prop;
+} prop_request_t;
+
+/* A null-terminated copy of a text property, or NULL if it is unset */
+static char *text_from_reply(xcb_get_property_reply_t *reply)
+{
+    int len;
+    char *text;
+
+    if (!reply || reply->type == XCB_NONE || reply->format != 8)
+        return NULL;
+    len = xcb_get_property_value_length(reply);
+    text = (char *)malloc(len + 1);
+    memcpy(text, xcb_get_property_value(reply), len);
+    text[len] = '\0';
+    return text;
+}
+
+static void store_class(client_props_t *props, xcb_get_property_reply_t *reply)
+{
+    char *value = text_from_reply(reply);
+    size_t instance_len;
+
+    free(props->instance);
+    free(props->class);
+    props->instance = props->class = NULL;
+    if (!value)
+        return;
+    /* WM_CLASS is the instance and class names, each null-terminated */
+    instance_len = strlen(value);
+    props->instance = value;
+    if ((int)instance_len < xcb_get_property_value_length(reply))
+        props->class = strdup(value + instance_len + 1);
+}
+
+static void store_protocols(client_props_t *props, xcb_get_property_reply_t *reply)
+{
+    free(props->protocols);
+    props->protocols = NULL;
+    props->protocols_len = 0;
+    if (!reply || reply->type != XCB_ATOM_ATOM || reply->format != 32)
+        return;
+    props->protocols_len = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
+    props->protocols = (xcb_atom_t *)malloc(props->protocols_len * sizeof(xcb_atom_t));
+    memcpy(props->protocols, xcb_get_property_value(reply),
+           props->protocols_len * sizeof(xcb_atom_t));
+}
+
+static void prop_reply(void *reply, xcb_generic_error_t *error, void *data)
+{
+    prop_request_t *request = (prop_request_t *)data;
+    xcb_get_property_reply_t *prop = (xcb_get_property_reply_t *)reply;
+    client_t *client = find_client(request->window);
+    client_props_t *props;
+
+    /* the client may have gone away while the request was in flight */
+    if (!client) {
+        free(request);
+        return;
+    }
+    props = &client->props;
+
+    switch (request->prop) {
+    case CLIENT_PROP_WM_NAME:
+        free(props->wm_name);
+        props->wm_name = text_from_reply(prop);
+        break;
+    case CLIENT_PROP_NET_WM_NAME:
+        free(props->net_wm_name);
+        props->net_wm_name = text_from_reply(prop);
+        break;
+    case CLIENT_PROP_WM_CLASS:
+        store_class(props, prop);
+        break;
+    case CLIENT_PROP_WM_PROTOCOLS:
+        store_protocols(props, prop);
+        break;
+    case CLIENT_PROP_WM_HINTS:
+        if (!prop || !xcb_icccm_get_wm_hints_from_reply(&props->hints, prop))
+            memset(&props->hints, 0, sizeof(props->hints));
+        break;
+    case CLIENT_PROP_WM_NORMAL_HINTS:
+        if (!prop || !xcb_icccm_get_wm_size_hints_from_reply(&props->normal_hints, prop))
+            memset(&props->normal_hints, 0, sizeof(props->normal_hints));
+        break;
+    }
+    props->valid |= request->prop;
+    free(request);
+}
+
+static void fetch_one(client_t *client, unsigned int prop)
+{
+    xcb_connection_t *c = wm_conf.connection;
+    xcb_get_property_cookie_t cookie;
+    prop_request_t *request;
+
+    switch (prop) {
+    case CLIENT_PROP_WM_NAME:
+        cookie = xcb_get_property(c, 0, client->window, XCB_ATOM_WM_NAME,
+                                  XCB_GET_PROPERTY_TYPE_ANY, 0, MAX_TEXT_LENGTH);
+        break;
+    case CLIENT_PROP_NET_WM_NAME:
+        cookie = xcb_get_property(c, 0, client->window, atoms[ATOM_NET_WM_NAME],
+                                  atoms[ATOM_UTF8_STRING], 0, MAX_TEXT_LENGTH);
+        break;
+    case CLIENT_PROP_WM_CLASS:
+        cookie = xcb_icccm_get_wm_class(c, client->window);
+        break;
+    case CLIENT_PROP_WM_PROTOCOLS:
+        cookie = xcb_get_property(c, 0, client->window, atoms[ATOM_WM_PROTOCOLS],
+                                  XCB_ATOM_ATOM, 0, MAX_PROTOCOLS);
+        break;
+    case CLIENT_PROP_WM_HINTS:
+        cookie = xcb_icccm_get_wm_hints(c, client->window);
+        break;
+    case CLIENT_PROP_WM_NORMAL_HINTS:
+        cookie = xcb_icccm_get_wm_normal_hints(c, client->window);
+        break;
+    default:
+        return;
+    }
+
+    request = (prop_request_t *)malloc(sizeof(prop_request_t));
+    request->window = client->window;
+    request->prop = prop;
+    reply_queue_push(cookie.sequence, &prop_reply, request);
+}
+
+/* Ask for the given properties (CLIENT_PROP_* bits); the cache is
+ * updated as the replies come in.
+ */
+void client_props_fetch(client_t *client, unsigned int props)
+{
+    unsigned int prop;
+    for (prop = 1; prop & CLIENT_PROP_ALL; prop <<= 1) {
+        if (props & prop)
+            fetch_one(client, prop);
+    }
+}
+
+/* Refetch a property the server told us has changed */
+void client_props_property_changed(client_t *client, xcb_atom_t atom)
+{
+    if (atom == XCB_ATOM_WM_NAME)
+        fetch_one(client, CLIENT_PROP_WM_NAME);
+    else if (atom == atoms[ATOM_NET_WM_NAME])
+        fetch_one(client, CLIENT_PROP_NET_WM_NAME);
+    else if (atom == XCB_ATOM_WM_CLASS)
+        fetch_one(client, CLIENT_PROP_WM_CLASS);
+    else if (atom == atoms[ATOM_WM_PROTOCOLS])
+        fetch_one(client, CLIENT_PROP_WM_PROTOCOLS);
+    else if (atom == XCB_ATOM_WM_HINTS)
+        fetch_one(client, CLIENT_PROP_WM_HINTS);
+    else if (atom == XCB_ATOM_WM_NORMAL_HINTS)
+        fetch_one(client, CLIENT_PROP_WM_NORMAL_HINTS);
+}
+
+void client_props_clear(client_t *client)
+{
+    client_props_t *props = &client->props;
+    free(props->wm_name);
+    free(props->net_wm_name);
+    free(props->instance);
+    free(props->class);
+    free(props->protocols);
+    memset(props, 0, sizeof(client_props_t));
+}
+
+/* The window title, preferring the UTF-8 _NET_WM_NAME */
+const char *client_props_name(client_t *client)
+{
+    if (client->props.net_wm_name)
+        return client->props.net_wm_name;
+    if (client->props.wm_name)
+        return client->props.wm_name;
+    return "";
+}
+
+/* Whether the client lists protocol in WM_PROTOCOLS: 1 if it does, 0 if
+ * not, -1 if we don't know yet.
+ */
+int client_props_supports_protocol(client_t *client, xcb_atom_t protocol)
+{
+    uint32_t i;
+
+    if (!(client->props.valid & CLIENT_PROP_WM_PROTOCOLS))
+        return -1;
+    for (i = 0; i < client->props.protocols_len; ++i) {
+        if (client->props.protocols[i] == protocol)
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __CLIENT_PROPS_H__
+#define __CLIENT_PROPS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+#include <xcb/xcb_icccm.h>
+
+/* Cached copies of the window properties we care about.  Each is
+ * fetched without waiting when the client is managed and again when a
+ * PropertyNotify says it changed, so reading them never touches the
+ * wire.
+ */
+typedef struct client_props {
+    /* which of the properties below have arrived */
+    unsigned int valid;
+    char *wm_name;
+    char *net_wm_name;
+    char *instance;
+    char *class;
+    xcb_atom_t *protocols;
+    uint32_t protocols_len;
+    xcb_icccm_wm_hints_t hints;
+    xcb_size_hints_t normal_hints;
+} client_props_t;
+
+#define CLIENT_PROP_WM_NAME       (1 << 0)
+#define CLIENT_PROP_NET_WM_NAME   (1 << 1)
+#define CLIENT_PROP_WM_CLASS      (1 << 2)
+#define CLIENT_PROP_WM_PROTOCOLS  (1 << 3)
+#define CLIENT_PROP_WM_HINTS      (1 << 4)
+#define CLIENT_PROP_WM_NORMAL_HINTS (1 << 5)
+#define CLIENT_PROP_ALL           ((1 << 6) - 1)
+
+struct client;
+
+void client_props_fetch(struct client *, unsigned int);
+void client_props_property_changed(struct client *, xcb_atom_t);
+void client_props_clear(struct client *);
+const char *client_props_name(struct client *);
+int client_props_supports_protocol(struct client *, xcb_atom_t);
+
+#endif
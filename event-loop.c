@@ -0,0 +1,213 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+#include "event-loop.h"
+
+/* maximum number of ready watches handled per epoll_wait() */
+#define MAX_READY_WATCHES 32
+
+static int epoll_fd = -1;
+
+/* background tasks waiting to run, in FIFO order */
+static event_task_t *task_head = NULL;
+static event_task_t *task_tail = NULL;
+
+int event_loop_init(void)
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        return -1;
+    }
+    return 0;
+}
+
+int event_loop_add_fd(event_watch_t *watch, int fd, event_watch_func func, void *data)
+{
+    struct epoll_event ev;
+
+    watch->fd = fd;
+    watch->priority = EVENT_PRIORITY_NORMAL;
+    watch->func = func;
+    watch->data = data;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = watch;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("epoll_ctl add failed");
+        return -1;
+    }
+    return 0;
+}
+
+void event_loop_set_priority(event_watch_t *watch, int priority)
+{
+    watch->priority = priority;
+}
+
+void event_loop_remove(event_watch_t *watch)
+{
+    if (watch->fd < 0)
+        return;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watch->fd, NULL) < 0)
+        perror("epoll_ctl del failed");
+    watch->fd = -1;
+}
+
+static void dispatch_watch(event_watch_t *watch)
+{
+    watch->func(watch->data);
+}
+
+/* Block for up to timeout_ms milliseconds (forever if negative) until
+ * at least one watch is ready, then run the callback of every ready
+ * watch.  Returns the number of watches dispatched, or -1 on error.
+ */
+int event_loop_dispatch(int timeout_ms)
+{
+    struct epoll_event ready[MAX_READY_WATCHES];
+    int i, n;
+
+    n = epoll_wait(epoll_fd, ready, MAX_READY_WATCHES, timeout_ms);
+    if (n < 0) {
+        if (errno == EINTR)
+            return 0;
+        perror("epoll_wait error");
+        return -1;
+    }
+
+    /* input first, so it never waits behind a slow REPL callback */
+    for (i = 0; i < n; ++i) {
+        event_watch_t *watch = (event_watch_t *)ready[i].data.ptr;
+        if (watch->priority > EVENT_PRIORITY_NORMAL) {
+            dispatch_watch(watch);
+            ready[i].data.ptr = NULL;
+        }
+    }
+    for (i = 0; i < n; ++i) {
+        if (ready[i].data.ptr)
+            dispatch_watch((event_watch_t *)ready[i].data.ptr);
+    }
+    return n;
+}
+
+static event_task_t *task_pop(void)
+{
+    event_task_t *task = task_head;
+    if (task) {
+        task_head = task->next;
+        if (!task_head)
+            task_tail = NULL;
+        task->next = NULL;
+        task->queued = false;
+    }
+    return task;
+}
+
+static void task_push(event_task_t *task)
+{
+    task->next = NULL;
+    task->queued = true;
+    if (task_tail)
+        task_tail->next = task;
+    else
+        task_head = task;
+    task_tail = task;
+}
+
+/* Queue a task to be run by event_loop_run_tasks().  Queueing a task
+ * that is already queued does nothing.
+ */
+void event_loop_queue_task(event_task_t *task, event_task_func func, void *data)
+{
+    if (task->queued)
+        return;
+    task->func = func;
+    task->data = data;
+    task_push(task);
+}
+
+void event_loop_cancel_task(event_task_t *task)
+{
+    event_task_t **p;
+
+    if (!task->queued)
+        return;
+    for (p = &task_head; *p; p = &(*p)->next) {
+        if (*p == task) {
+            *p = task->next;
+            break;
+        }
+    }
+    task_tail = NULL;
+    for (p = &task_head; *p; p = &(*p)->next)
+        task_tail = *p;
+    task->next = NULL;
+    task->queued = false;
+}
+
+bool event_loop_has_tasks(void)
+{
+    return (task_head != NULL);
+}
+
+static long elapsed_usec(struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((now.tv_sec - since->tv_sec) * 1000000L +
+            (now.tv_nsec - since->tv_nsec) / 1000L);
+}
+
+/* Run queued tasks one unit at a time, round robin, until there are no
+ * more, budget_usec microseconds have passed, or should_yield (if
+ * given) says something more important is waiting.  At least one unit
+ * is always run, and a unit is never interrupted, so the budget can be
+ * overrun by however long the last one takes.  Returns the number of
+ * units run.
+ */
+int event_loop_run_tasks(long budget_usec, bool (*should_yield)(void))
+{
+    struct timespec begin;
+    event_task_t *task;
+    int units = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    while ((task = task_pop())) {
+        /* the task may already have queued itself again */
+        if (task->func(task->data) && !task->queued)
+            task_push(task);
+        ++units;
+        if (elapsed_usec(&begin) >= budget_usec)
+            break;
+        if (should_yield && should_yield())
+            break;
+    }
+    return units;
+}
@@ -0,0 +1,71 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __EVENT_LOOP_H__
+#define __EVENT_LOOP_H__
+
+#include <stdbool.h>
+
+typedef void (*event_watch_func)(void *data);
+
+/* Watches with a higher priority are dispatched first when several are
+ * ready at once.
+ */
+#define EVENT_PRIORITY_NORMAL 0
+#define EVENT_PRIORITY_INPUT 1
+
+/* A file descriptor watched by the event loop.  The
+ * structure is owned by the caller and has to stay valid for as long
+ * as it is registered.  A watch may remove itself from inside its
+ * own callback, but not other watches.
+ */
+typedef struct event_watch {
+    int fd;
+    int priority;
+    event_watch_func func;
+    void *data;
+} event_watch_t;
+
+/* A task returns true if it has more work to do and should be called
+ * again later.
+ */
+typedef bool (*event_task_func)(void *data);
+
+/* A piece of background work, run in small units when nothing more
+ * urgent is ready.  Like a watch, the structure is owned by the caller.
+ */
+typedef struct event_task {
+    event_task_func func;
+    void *data;
+    bool queued;
+    struct event_task *next;
+} event_task_t;
+
+int event_loop_init(void);
+int event_loop_add_fd(event_watch_t *, int, event_watch_func, void *);
+void event_loop_set_priority(event_watch_t *, int);
+void event_loop_remove(event_watch_t *);
+int event_loop_dispatch(int);
+void event_loop_queue_task(event_task_t *, event_task_func, void *);
+void event_loop_cancel_task(event_task_t *);
+bool event_loop_has_tasks(void);
+int event_loop_run_tasks(long, bool (*)(void));
+
+#endif
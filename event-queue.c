@@ -0,0 +1,228 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <xcb/xcb.h>
+
+#include "event.h"
+#include "event-queue.h"
+#include "event-record.h"
+
+event_queue_stats_t event_queue_stats;
+
+/* Events drained from xcb but not yet dispatched.  Folded events leave
+ * a NULL hole behind so the order of the others is preserved.
+ */
+static xcb_generic_event_t *batch[EVENT_BATCH_SIZE];
+static int batch_len = 0;
+
+/* The window an event is about, or XCB_NONE if we don't care */
+static xcb_window_t event_window(xcb_generic_event_t *event)
+{
+    switch (XCB_EVENT_RESPONSE_TYPE(event)) {
+    case XCB_KEY_PRESS:
+    case XCB_KEY_RELEASE:
+    case XCB_BUTTON_PRESS:
+    case XCB_BUTTON_RELEASE:
+    case XCB_MOTION_NOTIFY:
+        return ((xcb_motion_notify_event_t *)event)->event;
+    case XCB_ENTER_NOTIFY:
+    case XCB_LEAVE_NOTIFY:
+        return ((xcb_enter_notify_event_t *)event)->event;
+    case XCB_FOCUS_IN:
+    case XCB_FOCUS_OUT:
+        return ((xcb_focus_in_event_t *)event)->event;
+    case XCB_EXPOSE:
+        return ((xcb_expose_event_t *)event)->window;
+    case XCB_CREATE_NOTIFY:
+        return ((xcb_create_notify_event_t *)event)->window;
+    case XCB_DESTROY_NOTIFY:
+        return ((xcb_destroy_notify_event_t *)event)->window;
+    case XCB_UNMAP_NOTIFY:
+        return ((xcb_unmap_notify_event_t *)event)->window;
+    case XCB_MAP_NOTIFY:
+        return ((xcb_map_notify_event_t *)event)->window;
+    case XCB_MAP_REQUEST:
+        return ((xcb_map_request_event_t *)event)->window;
+    case XCB_REPARENT_NOTIFY:
+        return ((xcb_reparent_notify_event_t *)event)->window;
+    case XCB_CONFIGURE_NOTIFY:
+        return ((xcb_configure_notify_event_t *)event)->window;
+    case XCB_CONFIGURE_REQUEST:
+        return ((xcb_configure_request_event_t *)event)->window;
+    case XCB_PROPERTY_NOTIFY:
+        return ((xcb_property_notify_event_t *)event)->window;
+    case XCB_CLIENT_MESSAGE:
+        return ((xcb_client_message_event_t *)event)->window;
+    default:
+        return XCB_NONE;
+    }
+}
+
+/* Event types where a later event for the same window makes an
+ * earlier one redundant.
+ */
+static bool is_foldable(uint8_t type)
+{
+    switch (type) {
+    case XCB_MOTION_NOTIFY:
+    case XCB_EXPOSE:
+    case XCB_CONFIGURE_NOTIFY:
+    case XCB_CONFIGURE_REQUEST:
+    case XCB_MAP_REQUEST:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void fold_expose(xcb_expose_event_t *old, xcb_expose_event_t *new)
+{
+    int x1 = (old->x < new->x ? old->x : new->x);
+    int y1 = (old->y < new->y ? old->y : new->y);
+    int old_x2 = old->x + old->width, new_x2 = new->x + new->width;
+    int old_y2 = old->y + old->height, new_y2 = new->y + new->height;
+    int x2 = (old_x2 > new_x2 ? old_x2 : new_x2);
+    int y2 = (old_y2 > new_y2 ? old_y2 : new_y2);
+
+    /* the bounding box of both regions */
+    new->x = x1;
+    new->y = y1;
+    new->width = x2 - x1;
+    new->height = y2 - y1;
+}
+
+static void fold_configure_request(xcb_configure_request_event_t *old,
+                                   xcb_configure_request_event_t *new)
+{
+    /* keep the values only the older request asked for */
+    uint16_t mask = old->value_mask & ~new->value_mask;
+    if (mask & XCB_CONFIG_WINDOW_X)
+        new->x = old->x;
+    if (mask & XCB_CONFIG_WINDOW_Y)
+        new->y = old->y;
+    if (mask & XCB_CONFIG_WINDOW_WIDTH)
+        new->width = old->width;
+    if (mask & XCB_CONFIG_WINDOW_HEIGHT)
+        new->height = old->height;
+    if (mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+        new->border_width = old->border_width;
+    if (mask & XCB_CONFIG_WINDOW_SIBLING)
+        new->sibling = old->sibling;
+    if (mask & XCB_CONFIG_WINDOW_STACK_MODE)
+        new->stack_mode = old->stack_mode;
+    new->value_mask |= old->value_mask;
+}
+
+/* Merge whatever is still relevant from old into new, which replaces it */
+static void fold_event(xcb_generic_event_t *old, xcb_generic_event_t *new)
+{
+    switch (XCB_EVENT_RESPONSE_TYPE(new)) {
+    case XCB_EXPOSE:
+        fold_expose((xcb_expose_event_t *)old, (xcb_expose_event_t *)new);
+        break;
+    case XCB_CONFIGURE_REQUEST:
+        fold_configure_request((xcb_configure_request_event_t *)old,
+                               (xcb_configure_request_event_t *)new);
+        break;
+    default:
+        /* the newer event simply supersedes the older one */
+        break;
+    }
+}
+
+static void batch_append(xcb_generic_event_t *event)
+{
+    uint8_t type = XCB_EVENT_RESPONSE_TYPE(event);
+    xcb_window_t window;
+    int i;
+
+    ++event_queue_stats.received;
+    /* recordings get the stream as the server sent it, before folding */
+    event_record_write(event);
+    if (is_foldable(type) && (window = event_window(event)) != XCB_NONE) {
+        /* Only fold into the most recent event for the same window.  Any
+         * other kind of event for it in between (an unmap, say) stops
+         * the search, so nothing is reordered across it.  Sent events
+         * are never folded into real ones.
+         */
+        for (i = batch_len - 1; i >= 0; --i) {
+            if (batch[i] && event_window(batch[i]) == window)
+                break;
+        }
+        if (i >= 0 && batch[i]->response_type == event->response_type) {
+            fold_event(batch[i], event);
+            free(batch[i]);
+            batch[i] = NULL;
+            ++event_queue_stats.folded;
+            ++event_queue_stats.folded_by_type[type];
+        }
+    }
+    batch[batch_len++] = event;
+}
+
+/* Pass every event in the batch to handler, in order, and free them.
+ * Returns the number of events handled.
+ */
+int event_queue_dispatch(event_queue_handler_func handler)
+{
+    xcb_generic_event_t *event;
+    int i, handled = 0;
+
+    for (i = 0; i < batch_len; ++i) {
+        if (!(event = batch[i]))
+            continue;
+        batch[i] = NULL;
+        handler(event);
+        free(event);
+        ++handled;
+    }
+    batch_len = 0;
+    return handled;
+}
+
+/* Add an event (which the queue takes ownership of) to the batch,
+ * dispatching the batch first if it is full.
+ */
+int event_queue_push(xcb_generic_event_t *event, event_queue_handler_func handler)
+{
+    int handled = 0;
+    if (batch_len == EVENT_BATCH_SIZE)
+        handled = event_queue_dispatch(handler);
+    batch_append(event);
+    return handled;
+}
+
+/* Drain pending events from xcb (only those already read off the
+ * socket if queued_only is set), fold redundant ones, and pass the
+ * rest to handler in order.  Returns the number of events handled.
+ */
+int event_queue_process(xcb_connection_t *c, bool queued_only,
+                        event_queue_handler_func handler)
+{
+    xcb_generic_event_t *event;
+    int handled = 0;
+
+    while ((event = (queued_only ? xcb_poll_for_queued_event(c)
+                                 : xcb_poll_for_event(c))))
+        handled += event_queue_push(event, handler);
+    return handled + event_queue_dispatch(handler);
+}
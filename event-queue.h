@@ -0,0 +1,44 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __EVENT_QUEUE_H__
+#define __EVENT_QUEUE_H__
+
+#include <stdbool.h>
+#include <xcb/xcb.h>
+
+/* Maximum number of events drained from xcb before they are dispatched */
+#define EVENT_BATCH_SIZE 256
+
+typedef void (*event_queue_handler_func)(xcb_generic_event_t *);
+
+typedef struct event_queue_stats {
+    unsigned long received;
+    unsigned long folded;
+    unsigned long folded_by_type[128];
+} event_queue_stats_t;
+
+extern event_queue_stats_t event_queue_stats;
+
+int event_queue_dispatch(event_queue_handler_func);
+int event_queue_push(xcb_generic_event_t *, event_queue_handler_func);
+int event_queue_process(xcb_connection_t *, bool, event_queue_handler_func);
+
+#endif
@@ -0,0 +1,143 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#include "event-record.h"
+
+static FILE *record_file = NULL;
+static uint64_t record_start_ns;
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Start recording every event received from the server to path,
+ * replacing any recording already in progress.
+ */
+int event_record_start(const char *path)
+{
+    event_record_header_t header;
+
+    event_record_stop();
+    if (!(record_file = fopen(path, "wb"))) {
+        perror("failed to open event recording");
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, EVENT_RECORD_MAGIC, sizeof(header.magic));
+    header.version = EVENT_RECORD_VERSION;
+    header.record_size = sizeof(event_record_t);
+    if (fwrite(&header, sizeof(header), 1, record_file) != 1) {
+        perror("failed to write event recording header");
+        fclose(record_file);
+        record_file = NULL;
+        return -1;
+    }
+
+    record_start_ns = monotonic_ns();
+    fprintf(stderr, "recording X events to %s\n", path);
+    return 0;
+}
+
+void event_record_stop(void)
+{
+    if (!record_file)
+        return;
+    fclose(record_file);
+    record_file = NULL;
+    fprintf(stderr, "stopped recording X events\n");
+}
+
+bool event_record_active(void)
+{
+    return (record_file != NULL);
+}
+
+void event_record_write(xcb_generic_event_t *event)
+{
+    event_record_t record;
+
+    if (!record_file)
+        return;
+    record.time_ns = monotonic_ns() - record_start_ns;
+    memcpy(record.data, event, EVENT_RECORD_EVENT_SIZE);
+    /* stdio buffers this, the file is only written in large chunks */
+    if (fwrite(&record, sizeof(record), 1, record_file) != 1) {
+        perror("failed to write event recording");
+        event_record_stop();
+    }
+}
+
+/* Read a whole recording into memory, so replaying it isn't slowed
+ * down by file I/O.  Returns an array of *count malloc'd events, laid
+ * out like the ones xcb hands out, or NULL on failure.
+ */
+xcb_generic_event_t **event_record_load(const char *path, size_t *count)
+{
+    FILE *file;
+    event_record_header_t header;
+    event_record_t record;
+    xcb_generic_event_t **events = NULL;
+    size_t cap = 0;
+
+    *count = 0;
+    if (!(file = fopen(path, "rb"))) {
+        perror("failed to open event recording");
+        return NULL;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        strncmp(header.magic, EVENT_RECORD_MAGIC, sizeof(header.magic)) ||
+        header.version != EVENT_RECORD_VERSION ||
+        header.record_size != sizeof(event_record_t)) {
+        fprintf(stderr, "%s is not an nwm event recording\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        xcb_generic_event_t *event;
+        if (*count == cap) {
+            cap = (cap ? cap * 2 : 1024);
+            events = (xcb_generic_event_t **)realloc(events, cap * sizeof(*events));
+            if (!events) {
+                perror("event recording allocation failed");
+                exit(1);
+            }
+        }
+        event = (xcb_generic_event_t *)calloc(1, sizeof(xcb_generic_event_t));
+        memcpy(event, record.data, EVENT_RECORD_EVENT_SIZE);
+        events[(*count)++] = event;
+    }
+
+    fclose(file);
+    /* an empty recording is still a valid one */
+    if (!events)
+        events = (xcb_generic_event_t **)malloc(sizeof(*events));
+    return events;
+}
@@ -0,0 +1,56 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __EVENT_RECORD_H__
+#define __EVENT_RECORD_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/* Recording file layout (native byte order):
+ *
+ *   header:  char magic[8] = "NWMXREC", uint32 version, uint32 record size
+ *   records: uint64 nanoseconds since recording started,
+ *            the event's 32 bytes as received from the server
+ */
+#define EVENT_RECORD_MAGIC "NWMXREC"
+#define EVENT_RECORD_VERSION 1
+#define EVENT_RECORD_EVENT_SIZE 32
+
+typedef struct event_record_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+} event_record_header_t;
+
+typedef struct event_record {
+    uint64_t time_ns;
+    uint8_t data[EVENT_RECORD_EVENT_SIZE];
+} event_record_t;
+
+int event_record_start(const char *);
+void event_record_stop(void);
+bool event_record_active(void);
+void event_record_write(xcb_generic_event_t *);
+xcb_generic_event_t **event_record_load(const char *, size_t *);
+
+#endif
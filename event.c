@@ -35,6 +35,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "event.h"
 
@@ -75,20 +76,76 @@ get_error_handler(xcb_event_handlers_t *evenths, int error)
     return &evenths->error[error];
 }
 
+static uint64_t
+monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void
+record_latency(xcb_event_stats_t *stats, uint64_t ns)
+{
+    int bucket = 0;
+    /* floor(log2(ns)), clamped to the last bucket */
+    if(ns > 0)
+        bucket = 63 - __builtin_clzll(ns);
+    if(bucket >= XCB_EVENT_LATENCY_BUCKETS)
+        bucket = XCB_EVENT_LATENCY_BUCKETS - 1;
+
+    stats->count++;
+    stats->total_ns += ns;
+    if(ns > stats->max_ns)
+        stats->max_ns = ns;
+    stats->buckets[bucket]++;
+}
+
 int
 xcb_event_handle(xcb_event_handlers_t *evenths, xcb_generic_event_t *event)
 {
     xcb_event_handler_t *eventh = 0;
+    xcb_event_stats_t *stats;
+    uint64_t start;
+    int ret = 0;
     assert(event->response_type != 1);
 
     if(event->response_type == 0)
-        eventh = get_error_handler(evenths, ((xcb_generic_error_t *) event)->error_code);
+    {
+        uint8_t error_code = ((xcb_generic_error_t *) event)->error_code;
+        eventh = get_error_handler(evenths, error_code);
+        stats = &evenths->error_stats[error_code];
+    }
     else
+    {
         eventh = get_event_handler(evenths, event->response_type);
+        stats = &evenths->event_stats[event->response_type & XCB_EVENT_RESPONSE_TYPE_MASK];
+    }
 
+    start = monotonic_ns();
     if(eventh->handler)
-        return eventh->handler(eventh->data, evenths->c, event);
-    return 0;
+        ret = eventh->handler(eventh->data, evenths->c, event);
+    record_latency(stats, monotonic_ns() - start);
+    return ret;
+}
+
+const xcb_event_stats_t *
+xcb_event_get_stats(xcb_event_handlers_t *evenths, uint8_t type)
+{
+    return &evenths->event_stats[type & XCB_EVENT_RESPONSE_TYPE_MASK];
+}
+
+const xcb_event_stats_t *
+xcb_event_get_error_stats(xcb_event_handlers_t *evenths, uint8_t error)
+{
+    return &evenths->error_stats[error];
+}
+
+void
+xcb_event_reset_stats(xcb_event_handlers_t *evenths)
+{
+    memset(evenths->event_stats, 0, sizeof(evenths->event_stats));
+    memset(evenths->error_stats, 0, sizeof(evenths->error_stats));
 }
 
 void
@@ -72,11 +72,29 @@ struct xcb_event_handler
     void *data;
 };
 
+/**
+ * @brief Number of latency histogram buckets.  Bucket i counts handler
+ * runs that took between 2^i and 2^(i+1) nanoseconds; the last one also
+ * counts everything slower.
+ */
+#define XCB_EVENT_LATENCY_BUCKETS 32
+
+typedef struct xcb_event_stats xcb_event_stats_t;
+struct xcb_event_stats
+{
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[XCB_EVENT_LATENCY_BUCKETS];
+};
+
 typedef struct xcb_event_handlers xcb_event_handlers_t;
 struct xcb_event_handlers
 {
     xcb_event_handler_t event[126];
     xcb_event_handler_t error[256];
+    xcb_event_stats_t event_stats[128];
+    xcb_event_stats_t error_stats[256];
     xcb_connection_t *c;
 };
 
@@ -116,6 +134,28 @@ void xcb_event_poll_for_event_loop(xcb_event_handlers_t *evenths);
  */
 int xcb_event_handle(xcb_event_handlers_t *evenths, xcb_generic_event_t *event);
 
+/**
+ * @brief Get dispatch statistics for an event type.
+ * @param evenths The event handlers.
+ * @param type The event response type.
+ * @return The count and handler latency histogram for this event type.
+ */
+const xcb_event_stats_t *xcb_event_get_stats(xcb_event_handlers_t *evenths, uint8_t type);
+
+/**
+ * @brief Get dispatch statistics for an error code.
+ * @param evenths The event handlers.
+ * @param error The error code.
+ * @return The count and handler latency histogram for this error code.
+ */
+const xcb_event_stats_t *xcb_event_get_error_stats(xcb_event_handlers_t *evenths, uint8_t error);
+
+/**
+ * @brief Clear all event and error dispatch statistics.
+ * @param evenths The event handlers.
+ */
+void xcb_event_reset_stats(xcb_event_handlers_t *evenths);
+
 /**
  * @brief Set an event handler for an event type.
  * @param evenths The event handlers data structure.
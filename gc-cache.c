@@ -0,0 +1,76 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "gc-cache.h"
+
+typedef struct gc_entry {
+    xcb_gcontext_t gc;
+    uint32_t foreground;
+    uint16_t line_width;
+    /* when the entry was last used, for eviction */
+    unsigned long last_used;
+} gc_entry_t;
+
+static gc_entry_t entries[GC_CACHE_SIZE];
+static int entries_len = 0;
+static unsigned long use_clock = 0;
+
+/* A graphics context for drawable's screen with the given foreground
+ * and line width.  At most one request is sent: none for a cached
+ * context, a CreateGC for a new one, or a ChangeGC to reuse the least
+ * recently used one once the cache is full.
+ */
+xcb_gcontext_t gc_cache_get(xcb_connection_t *c, xcb_drawable_t drawable,
+                            uint32_t foreground, uint16_t line_width)
+{
+    const uint32_t mask = XCB_GC_FOREGROUND | XCB_GC_LINE_WIDTH |
+        XCB_GC_GRAPHICS_EXPOSURES;
+    uint32_t values[] = { foreground, line_width, 0 };
+    gc_entry_t *entry = NULL;
+    int i;
+
+    for (i = 0; i < entries_len; ++i) {
+        if (entries[i].foreground == foreground && entries[i].line_width == line_width) {
+            entries[i].last_used = ++use_clock;
+            return entries[i].gc;
+        }
+    }
+
+    if (entries_len < GC_CACHE_SIZE) {
+        entry = &entries[entries_len++];
+        entry->gc = xcb_generate_id(c);
+        xcb_create_gc(c, entry->gc, drawable, mask, values);
+    }
+    else {
+        entry = &entries[0];
+        for (i = 1; i < entries_len; ++i) {
+            if (entries[i].last_used < entry->last_used)
+                entry = &entries[i];
+        }
+        xcb_change_gc(c, entry->gc, mask, values);
+    }
+    entry->foreground = foreground;
+    entry->line_width = line_width;
+    entry->last_used = ++use_clock;
+    return entry->gc;
+}
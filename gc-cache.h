@@ -0,0 +1,37 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __GC_CACHE_H__
+#define __GC_CACHE_H__
+
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/* Graphics contexts for drawing on the root window, keyed by
+ * foreground color and line width.  They are created on first use and
+ * kept for the life of the connection; when the cache is full the
+ * least recently used one is changed to the new values instead.
+ */
+
+#define GC_CACHE_SIZE 16
+
+xcb_gcontext_t gc_cache_get(xcb_connection_t *, xcb_drawable_t, uint32_t, uint16_t);
+
+#endif
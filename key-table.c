@@ -0,0 +1,199 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <xcb/xcb.h>
+#include <libguile.h>
+
+#include "key-table.h"
+
+#define ROW_SIZE (KEY_TABLE_MODIFIERS + 1)
+
+/* rows[keycode] is NULL until something is bound to that keycode;
+ * unbound entries in a row are #f.
+ */
+static SCM *rows[256];
+
+/* The (keycode, modifiers) pairs currently grabbed, one bit each, and
+ * the keycodes whose row has changed since the last grab pass */
+static uint8_t grabbed[256][ROW_SIZE / 8];
+static uint8_t dirty[256 / 8];
+static bool any_dirty = false;
+/* the lock mask the grabs were made with, and whether it changed */
+static uint16_t grabbed_lock_mask = XCB_MOD_MASK_LOCK;
+static bool regrab_all = false;
+
+#define BIT_TEST(bits, i) ((bits)[(i) / 8] & (1 << ((i) % 8)))
+#define BIT_SET(bits, i) ((bits)[(i) / 8] |= (1 << ((i) % 8)))
+#define BIT_CLEAR(bits, i) ((bits)[(i) / 8] &= ~(1 << ((i) % 8)))
+
+static void mark_dirty(xcb_keycode_t keycode)
+{
+    BIT_SET(dirty, keycode);
+    any_dirty = true;
+}
+
+/* Modifiers that shouldn't change what a key does: Lock always, plus
+ * whichever modifier NumLock is on */
+static uint16_t lock_mask = XCB_MOD_MASK_LOCK;
+
+void key_table_set_lock_mask(uint16_t mask)
+{
+    int keycode;
+
+    if (mask == lock_mask)
+        return;
+    lock_mask = mask;
+    /* every grab has to be redone under the new lock combinations */
+    regrab_all = true;
+    for (keycode = 0; keycode < 256; ++keycode) {
+        if (rows[keycode])
+            mark_dirty(keycode);
+    }
+}
+
+uint16_t key_table_lock_mask(void)
+{
+    return lock_mask;
+}
+
+/* The modifier state a binding is looked up under */
+uint16_t key_table_normalize(uint16_t state)
+{
+    return state & KEY_TABLE_MODIFIERS & ~lock_mask;
+}
+
+static SCM *row_alloc(void)
+{
+    SCM *row = (SCM *)malloc(ROW_SIZE * sizeof(SCM));
+    int i;
+
+    if (!row) {
+        perror("key table allocation failed");
+        exit(1);
+    }
+    for (i = 0; i < ROW_SIZE; ++i)
+        row[i] = SCM_BOOL_F;
+    return row;
+}
+
+/* Bind proc to keycode with the given modifiers.  The table holds its
+ * own reference to proc, and drops the one to whatever it replaces.
+ */
+void key_table_set(xcb_keycode_t keycode, uint16_t mod_mask, SCM proc)
+{
+    uint16_t mods = key_table_normalize(mod_mask);
+
+    if (!rows[keycode])
+        rows[keycode] = row_alloc();
+    scm_gc_protect_object(proc);
+    if (scm_is_true(rows[keycode][mods]))
+        scm_gc_unprotect_object(rows[keycode][mods]);
+    rows[keycode][mods] = proc;
+    mark_dirty(keycode);
+}
+
+/* The procedure bound to a key press, or #f */
+SCM key_table_find(xcb_keycode_t keycode, uint16_t state)
+{
+    if (!rows[keycode])
+        return SCM_BOOL_F;
+    return rows[keycode][key_table_normalize(state)];
+}
+
+void key_table_clear(void)
+{
+    int keycode, mods;
+
+    for (keycode = 0; keycode < 256; ++keycode) {
+        if (!rows[keycode])
+            continue;
+        for (mods = 0; mods < ROW_SIZE; ++mods) {
+            if (scm_is_true(rows[keycode][mods]))
+                scm_gc_unprotect_object(rows[keycode][mods]);
+        }
+        free(rows[keycode]);
+        rows[keycode] = NULL;
+        mark_dirty(keycode);
+    }
+}
+
+bool key_table_grabs_pending(void)
+{
+    return any_dirty;
+}
+
+/* Grab or ungrab keycode with mods under every combination of the
+ * lock modifiers, since the table ignores them.
+ */
+static void grab_key(xcb_connection_t *c, xcb_window_t root, xcb_keycode_t keycode,
+                     uint16_t mods, bool grab)
+{
+    uint16_t locks = grabbed_lock_mask;
+
+    for (;;) {
+        if (grab)
+            xcb_grab_key(c, 1, root, mods | locks, keycode,
+                         XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+        else
+            xcb_ungrab_key(c, keycode, root, mods | locks);
+        if (!locks)
+            break;
+        locks = (locks - 1) & grabbed_lock_mask;
+    }
+}
+
+/* Bring the grabs on root in line with the table, touching only the
+ * keycodes that changed since the last pass.
+ */
+void key_table_apply_grabs(xcb_connection_t *c, xcb_window_t root)
+{
+    int keycode, mods;
+    bool bound;
+
+    if (!any_dirty)
+        return;
+    if (regrab_all) {
+        xcb_ungrab_key(c, XCB_GRAB_ANY, root, XCB_MOD_MASK_ANY);
+        memset(grabbed, 0, sizeof(grabbed));
+        grabbed_lock_mask = lock_mask;
+        regrab_all = false;
+    }
+    for (keycode = 0; keycode < 256; ++keycode) {
+        if (!BIT_TEST(dirty, keycode))
+            continue;
+        for (mods = 0; mods < ROW_SIZE; ++mods) {
+            bound = (rows[keycode] && scm_is_true(rows[keycode][mods]));
+            if (bound == !!BIT_TEST(grabbed[keycode], mods))
+                continue;
+            grab_key(c, root, keycode, mods, bound);
+            if (bound)
+                BIT_SET(grabbed[keycode], mods);
+            else
+                BIT_CLEAR(grabbed[keycode], mods);
+        }
+    }
+    memset(dirty, 0, sizeof(dirty));
+    any_dirty = false;
+}
@@ -0,0 +1,51 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __KEY_TABLE_H__
+#define __KEY_TABLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+#include <libguile.h>
+
+/* Key bindings by keycode and modifier state.  Each keycode with a
+ * binding gets a row with one entry per combination of the eight core
+ * modifiers, so finding the procedure for a key press is two array
+ * lookups however many keys are bound.  Lock and NumLock are ignored.
+ *
+ * The table also decides the key grabs on the root window.  Changes
+ * only mark keycodes dirty; key_table_apply_grabs then grabs and
+ * ungrabs just the differences, once per cycle.
+ */
+
+/* The core modifiers, without the pointer button bits of a key state */
+#define KEY_TABLE_MODIFIERS 0xff
+
+void key_table_set_lock_mask(uint16_t);
+uint16_t key_table_lock_mask(void);
+uint16_t key_table_normalize(uint16_t);
+void key_table_set(xcb_keycode_t, uint16_t, SCM);
+SCM key_table_find(xcb_keycode_t, uint16_t);
+void key_table_clear(void);
+bool key_table_grabs_pending(void);
+void key_table_apply_grabs(xcb_connection_t *, xcb_window_t);
+
+#endif
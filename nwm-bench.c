@@ -0,0 +1,310 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+/* A synthetic client for benchmarking a running nwm.  For each window
+ * count given on the command line it maps that many windows at once and
+ * measures how long each takes to reach its final geometry, then times
+ * a retile and a tag switch through the REPL socket, and counts the X
+ * requests and round trips nwm made for each.  See run-bench.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <xcb/xcb.h>
+#include <xcb/xcb_aux.h>
+
+/* How long nothing has to happen before we decide nwm is done */
+#define QUIET_MS 500
+#define RETILE_RUNS 5
+
+typedef struct bench_window {
+    xcb_window_t window;
+    double map_ms;
+    double configure_ms;
+    int mapped;
+} bench_window_t;
+
+typedef struct request_stats {
+    unsigned long requests;
+    unsigned long round_trips;
+} request_stats_t;
+
+static xcb_connection_t *conn;
+static xcb_screen_t *screen;
+static int repl_fd;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int repl_connect(void)
+{
+    struct sockaddr_un remote;
+    char *home_path = getenv("HOME");
+    int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+
+    memset(&remote, 0, sizeof(remote));
+    remote.sun_family = AF_LOCAL;
+    snprintf(remote.sun_path, sizeof(remote.sun_path), "%s/.nwm/sock",
+             (home_path ? home_path : ""));
+    if (connect(fd, (struct sockaddr *)&remote, sizeof(remote)) < 0) {
+        perror("failed to connect to the nwm REPL");
+        exit(1);
+    }
+    return fd;
+}
+
+/* Evaluate expr in nwm and wait for the result, which the REPL server
+ * terminates with a null byte.
+ */
+static void repl_eval(const char *expr, char *result, size_t result_len)
+{
+    size_t len = 0;
+    ssize_t n;
+
+    if (write(repl_fd, expr, strlen(expr)) < 0) {
+        perror("REPL write failed");
+        exit(1);
+    }
+    while (len < result_len - 1) {
+        if ((n = read(repl_fd, result + len, result_len - 1 - len)) <= 0) {
+            perror("REPL read failed");
+            exit(1);
+        }
+        len += n;
+        if (memchr(result + len - n, '\0', n))
+            break;
+    }
+    result[len] = '\0';
+}
+
+static request_stats_t get_request_stats(void)
+{
+    char result[256];
+    request_stats_t stats = { 0, 0 };
+
+    repl_eval("(x-request-stats)", result, sizeof(result));
+    if (sscanf(result, "((requests . %lu) (round-trips . %lu))",
+               &stats.requests, &stats.round_trips) != 2)
+        fprintf(stderr, "unexpected x-request-stats result: %s\n", result);
+    return stats;
+}
+
+/* The requests and round trips nwm made between two samples, less the
+ * ones the measurement itself costs.
+ */
+static request_stats_t stats_since(request_stats_t before, int synced)
+{
+    request_stats_t after = get_request_stats();
+    request_stats_t delta;
+
+    /* the no-op behind x-request-stats, and the (sync) if any */
+    delta.requests = after.requests - before.requests - 1 - (synced ? 1 : 0);
+    delta.round_trips = after.round_trips - before.round_trips - (synced ? 1 : 0);
+    return delta;
+}
+
+static bench_window_t *find_window(bench_window_t *windows, int n, xcb_window_t window)
+{
+    int i;
+    for (i = 0; i < n; ++i) {
+        if (windows[i].window == window)
+            return &windows[i];
+    }
+    return NULL;
+}
+
+/* Handle events until nothing has arrived for QUIET_MS and, if
+ * wait_mapped is set, every window has been mapped.
+ */
+static void wait_until_quiet(bench_window_t *windows, int n, int wait_mapped)
+{
+    struct pollfd pfd = { xcb_get_file_descriptor(conn), POLLIN, 0 };
+    xcb_generic_event_t *event;
+    bench_window_t *bw;
+    int mapped = 0, i;
+
+    for (i = 0; i < n; ++i)
+        mapped += windows[i].mapped;
+
+    for (;;) {
+        while ((event = xcb_poll_for_event(conn))) {
+            switch (event->response_type & ~0x80) {
+            case XCB_MAP_NOTIFY:
+                bw = find_window(windows, n, ((xcb_map_notify_event_t *)event)->window);
+                if (bw && !bw->mapped) {
+                    bw->mapped = 1;
+                    ++mapped;
+                }
+                break;
+            case XCB_CONFIGURE_NOTIFY:
+                bw = find_window(windows, n, ((xcb_configure_notify_event_t *)event)->window);
+                if (bw)
+                    bw->configure_ms = now_ms();
+                break;
+            }
+            free(event);
+        }
+        if (xcb_connection_has_error(conn)) {
+            fprintf(stderr, "lost the X connection\n");
+            exit(1);
+        }
+        if (poll(&pfd, 1, QUIET_MS) == 0 && (!wait_mapped || mapped == n))
+            break;
+    }
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+/* Time an expression evaluated in nwm, which should end by syncing with
+ * the server so the time includes the requests it made.
+ */
+static double time_eval(const char *expr)
+{
+    char result[4096];
+    double begin = now_ms();
+    repl_eval(expr, result, sizeof(result));
+    return now_ms() - begin;
+}
+
+static void bench_window_storm(int n)
+{
+    bench_window_t *windows = (bench_window_t *)calloc(n, sizeof(bench_window_t));
+    double *latency = (double *)malloc(n * sizeof(double));
+    uint32_t mask = XCB_CW_EVENT_MASK;
+    uint32_t values[] = { XCB_EVENT_MASK_STRUCTURE_NOTIFY };
+    request_stats_t before, delta;
+    double retile_ms = 0, away_ms, back_ms, settle_ms = 0;
+    int i;
+
+    for (i = 0; i < n; ++i) {
+        windows[i].window = xcb_generate_id(conn);
+        xcb_create_window(conn, XCB_COPY_FROM_PARENT, windows[i].window,
+                          screen->root, 0, 0, 100, 100, 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                          mask, values);
+    }
+    xcb_aux_sync(conn);
+
+    /* map them all at once, as a session restore would */
+    before = get_request_stats();
+    for (i = 0; i < n; ++i) {
+        windows[i].map_ms = now_ms();
+        xcb_map_window(conn, windows[i].window);
+    }
+    xcb_flush(conn);
+    wait_until_quiet(windows, n, 1);
+    delta = stats_since(before, 0);
+
+    for (i = 0; i < n; ++i) {
+        latency[i] = (windows[i].configure_ms > 0
+                      ? windows[i].configure_ms - windows[i].map_ms : 0);
+        if (windows[i].configure_ms - windows[0].map_ms > settle_ms)
+            settle_ms = windows[i].configure_ms - windows[0].map_ms;
+    }
+    qsort(latency, n, sizeof(double), &compare_double);
+
+    printf("%d windows\n", n);
+    printf("  map request to final configure: p50 %.2f ms, p95 %.2f ms, max %.2f ms\n",
+           latency[n / 2], latency[(n * 95) / 100], latency[n - 1]);
+    printf("  all windows settled after %.2f ms, %lu requests, %lu round trips\n",
+           settle_ms, delta.requests, delta.round_trips);
+
+    before = get_request_stats();
+    for (i = 0; i < RETILE_RUNS; ++i)
+        retile_ms += time_eval("(begin (run-hook layout-hook) (sync))");
+    delta = stats_since(before, 0);
+    /* every run synced once */
+    delta.requests -= RETILE_RUNS;
+    delta.round_trips -= RETILE_RUNS;
+    printf("  retile: %.2f ms, %lu requests, %lu round trips\n",
+           retile_ms / RETILE_RUNS, delta.requests / RETILE_RUNS,
+           delta.round_trips / RETILE_RUNS);
+    wait_until_quiet(windows, n, 0);
+
+    /* tag 2 is empty in the default configuration, so this hides every
+     * window and then shows them all again */
+    before = get_request_stats();
+    away_ms = time_eval("(begin (tag-switch #\\2 tags-assoc) (run-hook layout-hook) (sync))");
+    delta = stats_since(before, 1);
+    wait_until_quiet(windows, n, 0);
+    printf("  tag switch away: %.2f ms, %lu requests, %lu round trips\n",
+           away_ms, delta.requests, delta.round_trips);
+
+    before = get_request_stats();
+    back_ms = time_eval("(begin (tag-switch #\\1 tags-assoc) (run-hook layout-hook) (sync))");
+    delta = stats_since(before, 1);
+    wait_until_quiet(windows, n, 0);
+    printf("  tag switch back: %.2f ms, %lu requests, %lu round trips\n",
+           back_ms, delta.requests, delta.round_trips);
+    fflush(stdout);
+
+    for (i = 0; i < n; ++i)
+        xcb_destroy_window(conn, windows[i].window);
+    xcb_flush(conn);
+    wait_until_quiet(windows, 0, 0);
+
+    free(latency);
+    free(windows);
+}
+
+int main(int argc, char **argv)
+{
+    int screen_num, i, n;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s N [N ...]\n", argv[0]);
+        exit(1);
+    }
+
+    conn = xcb_connect(NULL, &screen_num);
+    if (xcb_connection_has_error(conn)) {
+        fprintf(stderr, "failed to connect to the X server\n");
+        exit(1);
+    }
+    screen = xcb_aux_get_screen(conn, screen_num);
+    repl_fd = repl_connect();
+
+    for (i = 1; i < argc; ++i) {
+        if ((n = atoi(argv[i])) <= 0) {
+            fprintf(stderr, "bad window count: %s\n", argv[i]);
+            exit(1);
+        }
+        bench_window_storm(n);
+    }
+
+    close(repl_fd);
+    xcb_disconnect(conn);
+    exit(0);
+}
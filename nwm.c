@@ -26,7 +26,9 @@
 #include <string.h>
 #include <stdbool.h>
 #include <errno.h>
-#include <sys/time.h>
+#include <time.h>
+#include <getopt.h>
+#include <poll.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_event.h>
 #include <xcb/xcb_aux.h>
@@ -43,13 +45,24 @@
 #include "nwm.h"
 #include "scheme.h"
 #include "repl-server.h"
-
-typedef void (*event_loop_task_func)(void);
+#include "event-loop.h"
+#include "event-queue.h"
+#include "reply-queue.h"
+#include "event-record.h"
+#include "client-index.h"
+#include "client-pool.h"
+#include "client-props.h"
+#include "atoms.h"
+#include "key-table.h"
+#include "gc-cache.h"
+#include "root-damage.h"
+#include "client-geometry.h"
 
 nwm_t wm_conf;
 
 client_t *client_list = NULL;
-SGLIB_DEFINE_LIST_FUNCTIONS(client_t, COMPARE_CLIENT, next)
+client_t *client_list_tail = NULL;
+int client_count = 0;
 
 keybinding_t *keybinding_list = NULL;
 SGLIB_DEFINE_LIST_FUNCTIONS(keybinding_t, COMPARE_KEYBINDING, next)
@@ -59,17 +72,6 @@ void init_wm_conf(void)
     memset(&wm_conf, 0, sizeof(nwm_t));
 }
 
-client_t *client_alloc(void)
-{
-    return (client_t *) scm_gc_malloc(sizeof(client_t), "client");
-}
-
-client_t *client_init(client_t *client)
-{
-    memset(client, 0, sizeof(client_t));
-    return client;
-}
-
 keybinding_t *keybinding_alloc(void)
 {
     return (keybinding_t *)malloc(sizeof(keybinding_t));
@@ -107,41 +109,306 @@ void print_x_event(xcb_generic_event_t *event)
     fprintf(stderr, "X event %d : %s\n", event_type, label);
 }
 
-client_t * find_client(xcb_window_t win)
+static void commit_client_geometry(void);
+static void init_lock_mask(void);
+static void rebuild_key_table(void);
+static void note_focus_client(client_t *);
+
+/* Send all queued requests to the X server right away.  Requests are
+ * normally only flushed once per event loop cycle; use this when
+ * something outside of X (another process, say) depends on the
+ * requests having been seen by the server.
+ */
+void flush_requests(void)
 {
-    client_t *client = client_list;
+    commit_client_geometry();
+    xcb_flush(wm_conf.connection);
+}
+
+/* Flush, and wait until the server has processed every request sent */
+void sync_requests(void)
+{
+    commit_client_geometry();
+    xcb_aux_sync(wm_conf.connection);
+    ++wm_conf.round_trips;
+}
+
+/* Mark the layout as out of date.  The layout-hook runs at most once
+ * per event loop cycle, after all pending events have been handled,
+ * however many times this is called in between.
+ */
+void request_layout(void)
+{
+    wm_conf.layout_dirty = true;
+}
+
+static void run_pending_layout(void)
+{
+    if (!wm_conf.layout_dirty)
+        return;
+    run_hook("layout-hook", SCM_EOL);
+    /* cleared afterwards so that requests made by the layout itself
+     * don't schedule another pass */
+    wm_conf.layout_dirty = false;
+}
+
+static void list_link_before(client_t *client, client_t *pos)
+{
+    client->next = pos;
+    client->prev = (pos ? pos->prev : client_list_tail);
+    if (client->prev)
+        client->prev->next = client;
+    else
+        client_list = client;
+    if (pos)
+        pos->prev = client;
+    else
+        client_list_tail = client;
+}
+
+static void list_unlink(client_t *client)
+{
+    if (client->prev)
+        client->prev->next = client->next;
+    else
+        client_list = client->next;
+    if (client->next)
+        client->next->prev = client->prev;
+    else
+        client_list_tail = client->prev;
+    client->prev = client->next = NULL;
+}
+
+/* Clients are only ever added to and removed from client_list through
+ * these, which keep the window index in step with it.  New clients go
+ * to the front.
+ */
+void client_list_add(client_t *client)
+{
+    list_link_before(client, client_list);
+    ++client_count;
+    client_index_set(client->window, client);
+}
+
+void client_list_remove(client_t *client)
+{
+    list_unlink(client);
+    --client_count;
+    client_index_remove(client->window);
+}
+
+/* Reordering: client is taken out of the list and put back right
+ * before or after pos.
+ */
+void client_list_move_before(client_t *client, client_t *pos)
+{
+    if (client == pos)
+        return;
+    list_unlink(client);
+    list_link_before(client, pos);
+}
+
+void client_list_move_after(client_t *client, client_t *pos)
+{
+    if (client == pos)
+        return;
+    list_unlink(client);
+    list_link_before(client, pos->next);
+}
+
+void client_list_move_to_front(client_t *client)
+{
+    client_list_move_before(client, client_list);
+}
+
+/* Exchange the positions of two clients */
+void client_list_swap(client_t *client1, client_t *client2)
+{
+    client_t *after1;
+
+    if (client1 == client2)
+        return;
+    if (client1->next == client2) {
+        client_list_move_after(client1, client2);
+        return;
+    }
+    if (client2->next == client1) {
+        client_list_move_after(client2, client1);
+        return;
+    }
+    after1 = client1->next;
+    client_list_move_before(client1, client2);
+    list_unlink(client2);
+    list_link_before(client2, after1);
+}
+
+void client_list_reverse(void)
+{
+    client_t *client = client_list, *next;
+
+    client_list_tail = client_list;
     while (client) {
-        if (client->window == win)
-            return client;
-        client = client->next;
+        next = client->next;
+        client->next = client->prev;
+        client->prev = next;
+        if (!next)
+            client_list = client;
+        client = next;
     }
-    return NULL;
 }
 
-void clear_root(void)
+/* The clients after and before a client, wrapping around */
+client_t *client_next(client_t *client)
 {
-    xcb_aux_clear_window(wm_conf.connection, wm_conf.screen->root);
-    xcb_map_window(wm_conf.connection, wm_conf.screen->root);
-    xcb_flush(wm_conf.connection);
+    return (client->next ? client->next : client_list);
+}
+
+client_t *client_prev(client_t *client)
+{
+    return (client->prev ? client->prev : client_list_tail);
+}
+
+client_t * find_client(xcb_window_t win)
+{
+    return client_index_find(win);
+}
+
+/* Change a client's border width without changing the area it takes
+ * up on screen: the layout sized the window for the border it had,
+ * and borders are often only set afterwards (by auto-tile-hook, or
+ * after a border style switch), when asking for another layout would
+ * be too late to take effect this cycle.
+ */
+static void refit_border(client_t *client, int width)
+{
+    rect_t rect = client_geometry_rect(client);
+    int grow = 2 * ((int)client_geometry_border_width(client) - width);
+    int new_width = rect.width + grow, new_height = rect.height + grow;
+
+    client_geometry_set_border_width(client, width);
+    client_geometry_set_size(client, (new_width > 1 ? new_width : 1),
+                             (new_height > 1 ? new_height : 1));
+}
+
+/* Give the client's window an X border.  The color is only sent if it
+ * changed, and the width goes out with the rest of the geometry at the
+ * end of the cycle, so redrawing an unchanged border is free.
+ */
+static void set_server_border(client_t *client, uint32_t color, int width)
+{
+    if (!client->border_color_set || client->border_color != color) {
+        xcb_change_window_attributes(wm_conf.connection, client->window,
+                                     XCB_CW_BORDER_PIXEL, &color);
+        client->border_color = color;
+        client->border_color_set = true;
+    }
+    if (width != client_geometry_border_width(client))
+        refit_border(client, width);
+}
+
+/* The area of the root window a painted border covers */
+static xcb_rectangle_t root_border_rect(client_t *client, int width)
+{
+    rect_t geometry = client_geometry_rect(client);
+    xcb_rectangle_t rect = { geometry.x - (2 * width),
+                             geometry.y - (2 * width),
+                             geometry.width + (4 * width),
+                             geometry.height + (4 * width) };
+    return rect;
 }
 
 void draw_border(client_t *client, uint32_t color, int width)
 {
-    xcb_gcontext_t color_context = xcb_generate_id(wm_conf.connection);
-    uint32_t mask = XCB_GC_FOREGROUND;
-    uint32_t value[] = { color };
-    xcb_create_gc(wm_conf.connection, color_context, wm_conf.screen->root, mask, value);
-    xcb_rectangle_t rect[] = {{ client->rect.x - (2 * width),
-                                client->rect.y - (2 * width),
-                                client->rect.width + (4 * width),
-                                client->rect.height + (4 * width) }};
+    draw_borders(&client, 1, color, width);
+}
 
-    /* Draw the new border */
-    xcb_poly_fill_rectangle(wm_conf.connection, wm_conf.screen->root, color_context, 1, rect);
+/* Draw the same border around several clients.  Painted on the root,
+ * they all go out in a single PolyFillRectangle.
+ */
+void draw_borders(client_t **clients, int count, uint32_t color, int width)
+{
+    xcb_gcontext_t color_context;
+    xcb_rectangle_t *rects;
+    int i;
 
-    xcb_free_gc(wm_conf.connection, color_context);
-    xcb_map_window(wm_conf.connection, wm_conf.screen->root);
-    xcb_flush(wm_conf.connection);
+    if (wm_conf.border_style == BORDER_STYLE_SERVER) {
+        for (i = 0; i < count; ++i)
+            set_server_border(clients[i], color, width);
+        return;
+    }
+    if (count == 0)
+        return;
+    rects = (xcb_rectangle_t *)malloc(count * sizeof(xcb_rectangle_t));
+    if (!rects) {
+        perror("border drawing allocation failed");
+        exit(1);
+    }
+    for (i = 0; i < count; ++i) {
+        rects[i] = root_border_rect(clients[i], width);
+        clients[i]->root_border = rects[i];
+        clients[i]->root_border_width = width;
+        clients[i]->root_border_painted = true;
+    }
+    color_context = gc_cache_get(wm_conf.connection, wm_conf.screen->root, color, 0);
+    xcb_poly_fill_rectangle(wm_conf.connection, wm_conf.screen->root, color_context,
+                            count, rects);
+    free(rects);
+}
+
+/* Clear the parts of the root window that painted borders no longer
+ * belong on: those of clients that moved, were resized or unmapped
+ * since they were painted, or went away.  Areas the current borders
+ * cover are left alone, since they are about to be painted again.
+ * With server-side borders nothing is painted, so this costs nothing.
+ */
+void clear_root(void)
+{
+    client_t *client;
+    xcb_rectangle_t rect;
+
+    if (wm_conf.border_style == BORDER_STYLE_SERVER)
+        return;
+    for (client = client_list; client; client = client->next) {
+        if (!client->root_border_painted)
+            continue;
+        rect = root_border_rect(client, client->root_border_width);
+        if (client->mapped && rect.x == client->root_border.x &&
+            rect.y == client->root_border.y && rect.width == client->root_border.width &&
+            rect.height == client->root_border.height)
+            continue;
+        root_damage_add(&client->root_border);
+        client->root_border_painted = false;
+    }
+    for (client = client_list; client; client = client->next) {
+        if (!client->mapped)
+            continue;
+        rect = root_border_rect(client, client->root_border_width);
+        root_damage_subtract(&rect);
+    }
+    root_damage_clear(wm_conf.connection, wm_conf.screen->root);
+}
+
+/* Switch between server-side and root-painted borders.  Whatever the
+ * old style left behind is removed; borders in the new style appear
+ * the next time they are drawn.
+ */
+void set_border_style(border_style_t style)
+{
+    client_t *client;
+
+    if (style == wm_conf.border_style)
+        return;
+    if (wm_conf.border_style == BORDER_STYLE_ROOT) {
+        for (client = client_list; client; client = client->next)
+            client->root_border_painted = false;
+        root_damage_add_all();
+        root_damage_clear(wm_conf.connection, wm_conf.screen->root);
+    }
+    else
+        for (client = client_list; client; client = client->next)
+            client_geometry_set_border_width(client, 0);
+    wm_conf.border_style = style;
+    request_layout();
 }
 
 int handle_button_press_event(void *data, xcb_connection_t *c, xcb_button_press_event_t *event)
@@ -158,6 +425,14 @@ int handle_configure_request_event(void *data, xcb_connection_t *c, xcb_configur
 {
     uint16_t config_win_mask = 0;
     uint32_t config_win_vals[5];
+    client_t *client = find_client(event->window);
+
+    /* managed windows get the geometry the layout gave them, sent
+     * again so the client hears back */
+    if (client) {
+        client_geometry_invalidate(client);
+        return 0;
+    }
 
     config_win_mask |= (XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | 
                         XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT |
@@ -185,8 +460,7 @@ int handle_destroy_notify_event(void *data, xcb_connection_t *c, xcb_destroy_not
     client_t *client = find_client(event->window);
     if (client) {
         fprintf(stderr, "destroy notify: removing client window %u\n", client->window);
-        sglib_client_t_delete(&client_list, client);
-        destroy_client(client);
+        unmanage_client(client);
     }
     else {
         fprintf(stderr, "destroy notify: client window %u not found\n", event->window);
@@ -194,9 +468,26 @@ int handle_destroy_notify_event(void *data, xcb_connection_t *c, xcb_destroy_not
     return 0;
 }
 
+/* Focus follows the mouse: clients select EnterWindow when they are
+ * managed, so the pointer moving into one ends up here.
+ */
 int handle_enter_notify_event(void *data, xcb_connection_t *c, xcb_enter_notify_event_t *event)
 {
-    fprintf(stderr, "enter notify\n");
+    client_t *client;
+
+    /* ignore crossings caused by grabs, or from a window into its parent */
+    if (event->mode != XCB_NOTIFY_MODE_NORMAL ||
+        event->detail == XCB_NOTIFY_DETAIL_INFERIOR)
+        return 0;
+
+    client = find_client(event->event);
+    if (!client)
+        return 0;
+    /* only steal the focus when the pointer actually moved to another
+     * client, so keyboard focus changes aren't undone */
+    if (wm_conf.pointer_window != client->window)
+        set_focus_client(client);
+    wm_conf.pointer_window = client->window;
     return 0;
 }
 
@@ -206,8 +497,42 @@ int handle_leave_notify_event(void *data, xcb_connection_t *c, xcb_leave_notify_
     return 0;
 }
 
+/* Whether a focus event should update the tracked focus: not one
+ * caused by a keyboard grab or about the window under the pointer, and
+ * not one that predates our last SetInputFocus.
+ */
+static bool is_focus_change(xcb_focus_in_event_t *event)
+{
+    if (event->mode == XCB_NOTIFY_MODE_GRAB || event->mode == XCB_NOTIFY_MODE_UNGRAB ||
+        event->detail == XCB_NOTIFY_DETAIL_POINTER)
+        return false;
+    return ((int32_t)(((xcb_generic_event_t *)event)->full_sequence -
+                      wm_conf.focus_sequence) >= 0);
+}
+
 int handle_focus_in_event(void *data, xcb_connection_t *c, xcb_focus_in_event_t *event)
 {
+    client_t *client;
+
+    if (!is_focus_change(event))
+        return 0;
+    /* the focus went back to the root (PointerRoot or None) */
+    if (event->event == wm_conf.screen->root)
+        note_focus_client(NULL);
+    /* a client took the focus itself */
+    else if ((client = find_client(event->event)))
+        note_focus_client(client);
+    return 0;
+}
+
+/* The focused client lost the focus to a window we don't manage */
+int handle_focus_out_event(void *data, xcb_connection_t *c, xcb_focus_out_event_t *event)
+{
+    if (!is_focus_change((xcb_focus_in_event_t *)event) ||
+        event->detail == XCB_NOTIFY_DETAIL_INFERIOR)
+        return 0;
+    if (wm_conf.focus && event->event == wm_conf.focus->window)
+        note_focus_client(NULL);
     return 0;
 }
 
@@ -224,34 +549,25 @@ int handle_expose_event(void *data, xcb_connection_t *c, xcb_expose_event_t *eve
 void dump_client_list(void)
 {
     client_t *client = client_list;
+    rect_t rect;
     while (client) {
+        rect = client_geometry_rect(client);
         fprintf(stderr, "   window %u at (%d, %d) size (%d, %d)\n", 
                 client->window,
-                client->rect.x,
-                client->rect.y,
-                client->rect.width,
-                client->rect.height);
+                rect.x,
+                rect.y,
+                rect.width,
+                rect.height);
         client = client->next;
     }
 }
 
 int handle_key_press_event(void *data, xcb_connection_t *c, xcb_key_press_event_t *event)
 {
-    xcb_keycode_t keycode = event->detail;
-    xcb_keysym_t keysym = xcb_key_symbols_get_keysym(wm_conf.key_syms, keycode, 0);
-    fprintf(stderr, "key press: keycode %u, keysym %u, state %u\n", keycode, keysym, event->state);
-    /* search key bindings */
-    SCM key_proc = SCM_UNDEFINED;
-    keybinding_t *binding = keybinding_list;
-    while (binding) {
-        if (binding->keysym == keysym && binding->mod_mask == event->state) {
-            key_proc = binding->scm_proc;
-            break;
-        }
-        binding = binding->next;
-    }
+    SCM key_proc = key_table_find(event->detail, event->state);
 
-    if (key_proc != SCM_UNDEFINED)
+    fprintf(stderr, "key press: keycode %u, state %u\n", event->detail, event->state);
+    if (scm_is_true(key_proc))
         scm_call(key_proc, SCM_UNDEFINED);
 
     return 0;
@@ -265,228 +581,342 @@ int handle_key_release_event(void *data, xcb_connection_t *c, xcb_key_release_ev
 void map_client(client_t *client)
 {
     SCM client_smob = SCM_EOL;
-    xcb_map_window(wm_conf.connection, client->window);
-    /* the map won't happen immediately unless we flush the connection */
-    xcb_flush(wm_conf.connection);
-    client_smob = scm_new_smob(client_tag, (scm_t_bits) client);
+    xcb_void_cookie_t cookie = xcb_map_window(wm_conf.connection, client->window);
+    client->mapped = true;
+    client->map_sequence = cookie.sequence;
+    client_smob = client_to_scm(client);
     run_hook("map-client-hook", scm_list_1(client_smob));
 }
 
 void unmap_client(client_t *client)
 {
     SCM client_smob;
-    xcb_unmap_window(wm_conf.connection, client->window);
-    xcb_flush(wm_conf.connection);
-    client_smob = scm_new_smob(client_tag, (scm_t_bits) client);
+    xcb_void_cookie_t cookie = xcb_unmap_window(wm_conf.connection, client->window);
+    client->mapped = false;
+    client->map_sequence = cookie.sequence;
+    /* a hidden client loses the focus; unmap-client-hook may hand it on */
+    if (wm_conf.focus == client)
+        note_focus_client(NULL);
+    client_smob = client_to_scm(client);
     run_hook("unmap-client-hook", scm_list_1(client_smob));
 }
 
 bool is_mapped(client_t *client)
 {
-    xcb_get_window_attributes_cookie_t cookie;
-    xcb_get_window_attributes_reply_t *reply;
-    cookie = xcb_get_window_attributes(wm_conf.connection, client->window);
-    reply = xcb_get_window_attributes_reply(wm_conf.connection, cookie, NULL);
-    if (!reply)
-        return 0;
+    return client->mapped;
+}
 
-    if (reply->map_state == 0)
-        return false;
-    else
-        return true;
+/* Update a client's map state from a MapNotify or UnmapNotify, unless
+ * the event predates a map or unmap request of ours the server hasn't
+ * caught up with yet.
+ */
+static void note_map_state(client_t *client, xcb_generic_event_t *event, bool mapped)
+{
+    if ((int32_t)(event->full_sequence - client->map_sequence) < 0)
+        return;
+    client->mapped = mapped;
+    /* a window that unmapped itself can't keep the focus */
+    if (!mapped && wm_conf.focus == client)
+        note_focus_client(NULL);
 }
 
-void destroy_client(client_t *client)
+int handle_map_notify_event(void *data, xcb_connection_t *c, xcb_map_notify_event_t *event)
 {
-    SCM client_smob;
-    xcb_get_property_cookie_t cookie;
-    xcb_icccm_get_wm_protocols_reply_t protocols;
-    xcb_atom_t del_win_atom;
-    xcb_atom_t win_prot_atom;
-    uint32_t i;
-    int delete = 0;
-    
-    del_win_atom = get_atom("WM_DELETE_WINDOW");
-    win_prot_atom = get_atom("WM_PROTOCOLS");
-    cookie = xcb_icccm_get_wm_protocols_unchecked(wm_conf.connection, client->window,
-                                                  win_prot_atom);
-    if (xcb_icccm_get_wm_protocols_reply(wm_conf.connection, cookie, &protocols,
-                                         NULL) == 1) {
-        for (i = 0; i < protocols.atoms_len; i++)
-            if (protocols.atoms[i] == del_win_atom)
-                delete = 1;
-    }
-    xcb_icccm_get_wm_protocols_reply_wipe(&protocols);
-    if (delete == 1) {
+    client_t *client = find_client(event->window);
+    if (client)
+        note_map_state(client, (xcb_generic_event_t *)event, true);
+    return 0;
+}
+
+/* What a close request needs to know once WM_PROTOCOLS arrives */
+typedef struct close_request {
+    xcb_window_t window;
+    xcb_atom_t wm_protocols;
+    xcb_atom_t wm_delete_window;
+} close_request_t;
+
+/* Ask the window to close itself if it supports WM_DELETE_WINDOW,
+ * otherwise kill its connection.
+ */
+static void close_window(xcb_window_t window, bool delete,
+                         xcb_atom_t wm_protocols, xcb_atom_t wm_delete_window)
+{
+    if (delete) {
         xcb_client_message_event_t ev = {
             .response_type = XCB_CLIENT_MESSAGE,
             .format = 32,
             .sequence = 0,
-            .window = client->window,
-            .type = win_prot_atom,
-            .data.data32 = { del_win_atom, XCB_CURRENT_TIME }
+            .window = window,
+            .type = wm_protocols,
+            .data.data32 = { wm_delete_window, XCB_CURRENT_TIME }
         };
-        xcb_send_event(wm_conf.connection, 0, client->window, XCB_EVENT_MASK_NO_EVENT,
+        xcb_send_event(wm_conf.connection, 0, window, XCB_EVENT_MASK_NO_EVENT,
                        (char *) &ev);
     }
     else
-        xcb_kill_client(wm_conf.connection, client->window);
-    xcb_flush(wm_conf.connection);
-    client_smob = scm_new_smob(client_tag, (scm_t_bits) client);
-    run_hook("destroy-client-hook", scm_list_1(client_smob));
+        xcb_kill_client(wm_conf.connection, window);
 }
 
-/* Use the geometry data from client structure to configure the X window */
-void update_client_geometry(client_t *client)
+static void close_window_protocols_reply(void *reply, xcb_generic_error_t *error, void *data)
 {
-    SCM client_smob;
-    uint16_t config_win_mask = 0;
-    uint32_t config_win_vals[5];
+    close_request_t *request = (close_request_t *)data;
+    xcb_icccm_get_wm_protocols_reply_t protocols;
+    uint32_t i;
+    bool delete = false;
 
-    config_win_mask |= (XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y
-                        | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT
-                        | XCB_CONFIG_WINDOW_BORDER_WIDTH);
-
-    fprintf(stderr, "updating geometry for window %u to (%d,%d) + (%u,%u), border width=%u\n",
-            client->window,
-            client->rect.x,
-            client->rect.y,
-            client->rect.width,
-            client->rect.height,
-            client->border_width);
-    config_win_vals[0] = client->rect.x;
-    config_win_vals[1] = client->rect.y;
-    config_win_vals[2] = client->rect.width;
-    config_win_vals[3] = client->rect.height;
-    config_win_vals[4] = client->border_width;
-
-    xcb_configure_window(wm_conf.connection, client->window, config_win_mask, config_win_vals);
-    client_smob = scm_new_smob(client_tag, (scm_t_bits) client);
-    run_hook("update-client-hook", scm_list_1(client_smob));
-}
-
-/* Read the X window geometry and record it in the client structure */
-void read_client_geometry(client_t *client)
+    if (xcb_icccm_get_wm_protocols_from_reply((xcb_get_property_reply_t *)reply,
+                                              &protocols) == 1) {
+        for (i = 0; i < protocols.atoms_len; i++)
+            if (protocols.atoms[i] == request->wm_delete_window)
+                delete = true;
+    }
+    close_window(request->window, delete, request->wm_protocols,
+                 request->wm_delete_window);
+    free(request);
+}
+
+/* Ask a client to close.  It stays managed until its window is
+ * actually destroyed.  WM_PROTOCOLS normally comes from the property
+ * cache; it is only fetched here if that hasn't arrived yet.
+ */
+void destroy_client(client_t *client)
 {
-    xcb_get_geometry_cookie_t geometry_cookie;
-    xcb_get_geometry_reply_t *geometry_reply;
-    geometry_cookie = xcb_get_geometry_unchecked(wm_conf.connection, client->window);
-    geometry_reply = xcb_get_geometry_reply(wm_conf.connection, geometry_cookie, NULL);
-    if (geometry_reply) {
-        client->rect.x = geometry_reply->x;
-        client->rect.y = geometry_reply->y;
-        client->rect.width = geometry_reply->width;
-        client->rect.height = geometry_reply->height;
-        client->border_width = geometry_reply->border_width;
-        free(geometry_reply);
+    xcb_get_property_cookie_t cookie;
+    close_request_t *request;
+    xcb_atom_t wm_delete_window = atoms[ATOM_WM_DELETE_WINDOW];
+    xcb_atom_t wm_protocols = atoms[ATOM_WM_PROTOCOLS];
+    int supported = client_props_supports_protocol(client, wm_delete_window);
+
+    if (supported >= 0) {
+        close_window(client->window, supported, wm_protocols, wm_delete_window);
+        return;
     }
-    else {
-        fprintf(stderr, "  ! failed to get geometry geometry for window %u\n", client->window);
+    request = (close_request_t *)malloc(sizeof(close_request_t));
+    request->window = client->window;
+    request->wm_delete_window = wm_delete_window;
+    request->wm_protocols = wm_protocols;
+    cookie = xcb_icccm_get_wm_protocols(wm_conf.connection, client->window,
+                                        request->wm_protocols);
+    reply_queue_push(cookie.sequence, &close_window_protocols_reply, request);
+}
+
+/* Stop managing a client whose window is gone or withdrawn, and free
+ * it.  The client is taken out of client_list (and loses the focus)
+ * before destroy-client-hook runs, so the hook can't hand the focus
+ * back to it; Scheme references to it are dead afterwards.
+ */
+void unmanage_client(client_t *client)
+{
+    if (wm_conf.focus == client)
+        wm_conf.focus = NULL;
+    if (client->root_border_painted)
+        root_damage_add(&client->root_border);
+    client_list_remove(client);
+    run_hook("destroy-client-hook", scm_list_1(client_to_scm(client)));
+    client_geometry_detach(client);
+    client_props_clear(client);
+    client_release_scm(client);
+    client_pool_free(client);
+}
+
+static void client_geometry_changed(client_t *client)
+{
+    rect_t rect = client_geometry_rect(client);
+
+    fprintf(stderr, "updated geometry for window %u to (%d,%d) + (%u,%u), border width=%u\n",
+            client->window, rect.x, rect.y, rect.width, rect.height,
+            client_geometry_border_width(client));
+    run_hook("update-client-hook", scm_list_1(client_to_scm(client)));
+}
+
+/* Configure every client whose geometry changed this cycle.  The
+ * update-client-hook may move clients again, so repeat a few times
+ * until things settle.
+ */
+static void commit_client_geometry(void)
+{
+    int pass;
+    for (pass = 0; pass < 4 && client_geometry_pending(); ++pass)
+        client_geometry_commit(wm_conf.connection, &client_geometry_changed);
+}
+
+/* Record X window geometry in the client structure */
+static void store_client_geometry(client_t *client, xcb_get_geometry_reply_t *geometry)
+{
+    rect_t rect = { geometry->x, geometry->y, geometry->width, geometry->height };
+    client_geometry_set_applied(client, &rect, geometry->border_width);
+}
+
+static void client_geometry_reply(void *reply, xcb_generic_error_t *error, void *data)
+{
+    xcb_window_t window = (xcb_window_t)(uintptr_t)data;
+    client_t *client;
+
+    if (!reply) {
+        fprintf(stderr, "  ! failed to get geometry geometry for window %u\n", window);
+        return;
     }
+    /* the client may have gone away while the request was in flight */
+    if ((client = find_client(window)))
+        store_client_geometry(client, (xcb_get_geometry_reply_t *)reply);
+}
+
+/* Read the X window geometry and record it in the client structure
+ * once the reply arrives.
+ */
+void read_client_geometry(client_t *client)
+{
+    xcb_get_geometry_cookie_t cookie = xcb_get_geometry(wm_conf.connection, client->window);
+    reply_queue_push(cookie.sequence, &client_geometry_reply,
+                     (void *)(uintptr_t)client->window);
 }
 
+/* Copy the client's title into name_out, which holds 256 bytes */
 void get_client_name(client_t *client, char *name_out)
 {
-    xcb_get_property_cookie_t c;
-    xcb_icccm_get_text_property_reply_t *r;
-    char *name = "";
-    int res;
-    int len = 0;
-
-    c = xcb_icccm_get_wm_name(wm_conf.connection, client->window);
-    res = xcb_icccm_get_wm_name_reply(wm_conf.connection, c, r, NULL);
-    if (res == 1) {
-        len = xcb_get_property_value_length((xcb_get_property_reply_t *) r);
-        if (len > 0)
-            name = (char *)xcb_get_property_value((xcb_get_property_reply_t *) r);
-        /* sort of arbitrary name length limit (leaving one byte for
-         * the null character) */
-        if (len > 255)
-            len = 255;
-    }
-    else
-        fprintf(stderr, "failed to get wm_name\n");
-    free(r);
-    strncpy(name_out, name, len+1);
+    /* sort of arbitrary name length limit (leaving one byte for the
+     * null character) */
+    strncpy(name_out, client_props_name(client), 255);
+    name_out[255] = '\0';
 }
 
+/* The focused client, as tracked from our own focus changes and
+ * FocusIn events, so asking costs no round trip.
+ */
 client_t *get_focus_client(void)
 {
-    xcb_get_input_focus_cookie_t c = xcb_get_input_focus(wm_conf.connection);
-    xcb_get_input_focus_reply_t *r = xcb_get_input_focus_reply(wm_conf.connection, c, NULL);
-    client_t *focus_client = NULL;
+    return wm_conf.focus;
+}
 
-    if (r) {
-        focus_client = find_client(r->focus);
-        free(r);
-    }
-    return focus_client;
+/* Record that the focus moved to client (which may be NULL) and run
+ * focus-change-hook with the old and new clients, or #f for none, so
+ * decorations can be redrawn for just those two.
+ */
+static void note_focus_client(client_t *client)
+{
+    client_t *old = wm_conf.focus;
+
+    if (client == old)
+        return;
+    wm_conf.focus = client;
+    run_hook("focus-change-hook",
+             scm_list_2((old ? client_to_scm(old) : SCM_BOOL_F),
+                        (client ? client_to_scm(client) : SCM_BOOL_F)));
 }
 
 void set_focus_client(client_t *client)
 {
     SCM client_smob;
-    xcb_void_cookie_t c = xcb_set_input_focus_checked(wm_conf.connection, 
-                                                      XCB_INPUT_FOCUS_POINTER_ROOT,
-                                                      client->window,
-                                                      XCB_CURRENT_TIME);
-    xcb_generic_error_t *e = xcb_request_check(wm_conf.connection, c);
     const static uint32_t values[] = {XCB_STACK_MODE_ABOVE};
-    
-    if (e) {
-        fprintf(stderr, "xcb_set_input_focus_checked error: %s\n", 
-                xcb_event_get_error_label(e->error_code));
-        free(e);
-    }
+    xcb_void_cookie_t cookie;
+
+    /* not checked: waiting for the outcome would cost a round trip,
+     * and errors are reported by the error handler anyway */
+    cookie = xcb_set_input_focus(wm_conf.connection, XCB_INPUT_FOCUS_POINTER_ROOT,
+                                 client->window, XCB_CURRENT_TIME);
+    /* focus events from before this request are stale */
+    wm_conf.focus_sequence = cookie.sequence;
     xcb_configure_window(wm_conf.connection, client->window,
                          XCB_CONFIG_WINDOW_STACK_MODE, values);
-    client_smob = scm_new_smob(client_tag, (scm_t_bits) client);
+    note_focus_client(client);
+    client_smob = client_to_scm(client);
     run_hook("focus-client-hook", scm_list_1(client_smob));
 }
 
-client_t *manage_window(xcb_window_t window)
+client_t *manage_window(xcb_window_t window, xcb_get_geometry_reply_t *geometry)
 {
     SCM client_smob;
-    client_t *client = client_init(client_alloc());
+    client_t *client = client_pool_alloc();
+    const uint32_t event_mask = CLIENT_EVENT_MASK;
     client->window = window;
-    sglib_client_t_add(&client_list, client);
+    client_list_add(client);
+    client_geometry_attach(client);
+
+    xcb_change_window_attributes(wm_conf.connection, window, XCB_CW_EVENT_MASK, &event_mask);
 
-    read_client_geometry(client);
-    client->border_width = 0;
-    update_client_geometry(client);
+    if (geometry)
+        store_client_geometry(client, geometry);
+    client_geometry_set_border_width(client, 0);
+    client_props_fetch(client, CLIENT_PROP_ALL);
 
-    client_smob = scm_new_smob(client_tag, (scm_t_bits) client);
+    client_smob = client_to_scm(client);
     run_hook("create-client-hook", scm_list_1(client_smob));
 
     map_client(client);
     return client;    
 }
 
-int handle_map_request_event(void *data, xcb_connection_t *c, xcb_map_request_event_t *event)
+/* State shared by the requests issued for a MapRequest */
+typedef struct map_request {
+    xcb_window_t window;
+    bool manage;
+} map_request_t;
+
+static void map_request_attributes_reply(void *reply, xcb_generic_error_t *error, void *data)
 {
-    xcb_get_window_attributes_cookie_t win_attrs_cookie;
-    xcb_get_window_attributes_reply_t *win_attrs_reply;
-    win_attrs_cookie = xcb_get_window_attributes_unchecked(c, event->window);
-    win_attrs_reply = xcb_get_window_attributes_reply(c, win_attrs_cookie, NULL);
+    xcb_get_window_attributes_reply_t *win_attrs_reply = (xcb_get_window_attributes_reply_t *)reply;
+    map_request_t *request = (map_request_t *)data;
+
     if (!win_attrs_reply) {
         fprintf(stderr, "map request: failed to get window attributes\n");
-        return -1;
+        return;
     }
 
     if (win_attrs_reply->override_redirect) {
         fprintf(stderr, "map request: window has override redirect set - ignoring map request\n");
-        return 0;
+        return;
     }
 
+    request->manage = true;
+}
+
+/* The geometry request is sent right after the attributes request, so
+ * its reply always comes second and finishes the job.
+ */
+static void map_request_geometry_reply(void *reply, xcb_generic_error_t *error, void *data)
+{
+    map_request_t *request = (map_request_t *)data;
     client_t *client = NULL;
 
-    client = find_client(event->window);
-    if (!client)
-        client = manage_window(event->window);
+    /* the window is already gone, so there is nothing to manage */
+    if (!reply) {
+        fprintf(stderr, "map request: failed to get window geometry\n");
+        free(request);
+        return;
+    }
+    if (request->manage) {
+        /* manage_window maps the window itself */
+        client = find_client(request->window);
+        if (!client)
+            manage_window(request->window, (xcb_get_geometry_reply_t *)reply);
+        else
+            map_client(client);
+    }
+    free(request);
+}
 
-    map_client(client);
+int handle_map_request_event(void *data, xcb_connection_t *c, xcb_map_request_event_t *event)
+{
+    xcb_get_window_attributes_cookie_t win_attrs_cookie;
+    xcb_get_geometry_cookie_t geometry_cookie;
+    map_request_t *request;
+    client_t *client = find_client(event->window);
 
-    free(win_attrs_reply);
+    /* nothing to ask the server about a window we already manage */
+    if (client) {
+        map_client(client);
+        return 0;
+    }
+
+    request = (map_request_t *)malloc(sizeof(map_request_t));
+    request->window = event->window;
+    request->manage = false;
+
+    /* send both requests at once instead of waiting for each reply */
+    win_attrs_cookie = xcb_get_window_attributes(c, event->window);
+    geometry_cookie = xcb_get_geometry(c, event->window);
+    reply_queue_push(win_attrs_cookie.sequence, &map_request_attributes_reply, request);
+    reply_queue_push(geometry_cookie.sequence, &map_request_geometry_reply, request);
 
     return 0;
 }
@@ -494,12 +924,13 @@ int handle_map_request_event(void *data, xcb_connection_t *c, xcb_map_request_ev
 int handle_unmap_notify_event(void *data, xcb_connection_t *c, xcb_unmap_notify_event_t *event)
 {
     client_t *client = find_client(event->window);
+    if (client && !XCB_EVENT_SENT(event))
+        note_map_state(client, (xcb_generic_event_t *)event, false);
     if (client && XCB_EVENT_SENT(event)) {
         fprintf(stderr, "unmap notify: unmapping window %u\n", client->window);
-        sglib_client_t_delete(&client_list, client);
         unmap_client(client);
         xcb_map_window(wm_conf.connection, event->event);
-        free(client);
+        unmanage_client(client);
     }
 
     /* not right */
@@ -508,6 +939,14 @@ int handle_unmap_notify_event(void *data, xcb_connection_t *c, xcb_unmap_notify_
     return 0;
 }
 
+int handle_property_notify_event(void *data, xcb_connection_t *c, xcb_property_notify_event_t *event)
+{
+    client_t *client = find_client(event->window);
+    if (client)
+        client_props_property_changed(client, event->atom);
+    return 0;
+}
+
 int handle_client_message_event(void *data, xcb_connection_t *c, xcb_client_message_event_t *event)
 {
     return 0;
@@ -519,6 +958,12 @@ int handle_client_message_event(void *data, xcb_connection_t *c, xcb_client_mess
  */
 int handle_mapping_notify_event(void *data, xcb_connection_t *c, xcb_mapping_notify_event_t *event)
 {
+    if (event->request == XCB_MAPPING_POINTER)
+        return 0;
+    xcb_refresh_keyboard_mapping(wm_conf.key_syms, event);
+    if (event->request == XCB_MAPPING_MODIFIER)
+        init_lock_mask();
+    rebuild_key_table();
     return 0;
 }
 
@@ -537,12 +982,15 @@ void set_event_handlers(xcb_event_handlers_t *handlers)
     xcb_event_set_enter_notify_handler(handlers, handle_enter_notify_event, NULL);
     xcb_event_set_leave_notify_handler(handlers, handle_leave_notify_event, NULL);
     xcb_event_set_focus_in_handler(handlers, handle_focus_in_event, NULL);
+    xcb_event_set_focus_out_handler(handlers, handle_focus_out_event, NULL);
     xcb_event_set_motion_notify_handler(handlers, handle_motion_notify_event, NULL);
     xcb_event_set_expose_handler(handlers, handle_expose_event, NULL);
     xcb_event_set_key_press_handler(handlers, handle_key_press_event, NULL);
     xcb_event_set_key_release_handler(handlers, handle_key_release_event, NULL);
     xcb_event_set_map_request_handler(handlers, handle_map_request_event, NULL);
     xcb_event_set_unmap_notify_handler(handlers, handle_unmap_notify_event, NULL);
+    xcb_event_set_map_notify_handler(handlers, handle_map_notify_event, NULL);
+    xcb_event_set_property_notify_handler(handlers, handle_property_notify_event, NULL);
     xcb_event_set_client_message_handler(handlers, handle_client_message_event, NULL);
     xcb_event_set_mapping_notify_handler(handlers, handle_mapping_notify_event, NULL);
     xcb_event_set_reparent_notify_handler(handlers, handle_reparent_notify_event, NULL);
@@ -555,21 +1003,10 @@ void set_exclusive_error_handler(xcb_event_handlers_t *handlers, xcb_generic_err
         xcb_event_set_error_handler(handlers, i, handler, NULL);
 }
 
+/* The atom for atom_name, from the atom cache if it has been seen before */
 xcb_atom_t get_atom(char *atom_name)
 {
-    xcb_intern_atom_cookie_t atom_cookie;
-    xcb_atom_t atom;
-    xcb_intern_atom_reply_t *reply;
-
-    atom_cookie = xcb_intern_atom(wm_conf.connection, 0, strlen(atom_name), atom_name);
-    reply = xcb_intern_atom_reply(wm_conf.connection, atom_cookie, NULL);
-    if (reply != NULL) {
-        atom = reply->atom;
-        free(reply);
-        return atom;
-    }
-
-    return 0;
+    return atoms_intern(atom_name);
 }
 
 void scan_windows(void)
@@ -596,6 +1033,7 @@ void scan_windows(void)
         root_tree_replies[screen_idx] = xcb_query_tree_reply(wm_conf.connection,
                                                              root_tree_cookies[screen_idx],
                                                              NULL);
+        ++wm_conf.round_trips;
         if (!root_tree_replies[screen_idx])
             continue;
         wins = xcb_query_tree_children(root_tree_replies[screen_idx]);
@@ -617,7 +1055,7 @@ void scan_windows(void)
                from .xinitrc */
 
             /* if (!client) { */
-            /*     client = client_init(client_alloc()); */
+            /*     client = client_pool_alloc(); */
             /*     client->window = child_win; */
             /*     sglib_client_t_add(&client_list, client); */
             /* } */
@@ -638,6 +1076,7 @@ void xinerama_test(void)
         r = xcb_xinerama_is_active_reply(wm_conf.connection,
                                          xcb_xinerama_is_active(wm_conf.connection),
                                          NULL);
+        ++wm_conf.round_trips;
         wm_conf.xinerama_is_active = r->state;
         free(r);
     }
@@ -650,6 +1089,7 @@ void xinerama_test(void)
         r = xcb_xinerama_query_screens_reply(wm_conf.connection,
                                              xcb_xinerama_query_screens_unchecked(wm_conf.connection),
                                              NULL);
+        ++wm_conf.round_trips;
         screen_info = xcb_xinerama_query_screens_screen_info(r);
         num_screens = xcb_xinerama_query_screens_screen_info_length(r);
         fprintf(stderr, "xinerama: num_screens=%d\n", num_screens);
@@ -696,49 +1136,99 @@ xcb_keysym_t get_keysym(char *key)
     return keysym;
 }
 
-int bind_key(xcb_key_but_mask_t mod_mask, xcb_keysym_t keysym, SCM proc)
+/* Work out which modifier NumLock is on, so key bindings can ignore it
+ * along with CapsLock.
+ */
+static void init_lock_mask(void)
+{
+    xcb_get_modifier_mapping_cookie_t cookie = xcb_get_modifier_mapping(wm_conf.connection);
+    xcb_get_modifier_mapping_reply_t *reply;
+    xcb_keycode_t *num_lock, *modifiers;
+    uint16_t num_lock_mask = 0;
+    int mod, i, j;
+
+    num_lock = xcb_key_symbols_get_keycode(wm_conf.key_syms, XK_Num_Lock);
+    reply = xcb_get_modifier_mapping_reply(wm_conf.connection, cookie, NULL);
+    ++wm_conf.round_trips;
+    if (reply && num_lock) {
+        modifiers = xcb_get_modifier_mapping_keycodes(reply);
+        for (mod = 0; mod < 8; ++mod) {
+            for (i = 0; i < reply->keycodes_per_modifier; ++i) {
+                xcb_keycode_t keycode = modifiers[mod * reply->keycodes_per_modifier + i];
+                for (j = 0; keycode != XCB_NO_SYMBOL && num_lock[j] != XCB_NO_SYMBOL; ++j) {
+                    if (num_lock[j] == keycode)
+                        num_lock_mask = (1 << mod);
+                }
+            }
+        }
+    }
+    free(num_lock);
+    free(reply);
+    key_table_set_lock_mask(XCB_MOD_MASK_LOCK | num_lock_mask);
+}
+
+/* Enter a binding's procedure in the key table under every keycode
+ * that currently produces its keysym.
+ */
+static void key_table_add_binding(keybinding_t *binding)
 {
-    xcb_grab_server(wm_conf.connection);
     xcb_keycode_t *keycode_array = xcb_key_symbols_get_keycode(wm_conf.key_syms,
-                                                               keysym);
+                                                               binding->keysym);
     xcb_keycode_t keycode;
     int i = 0;
-    if (keycode_array) {
-        while ((keycode = keycode_array[i++]) != XCB_NO_SYMBOL) {
-            xcb_grab_key(wm_conf.connection, 1, wm_conf.screen->root,
-                         mod_mask, keycode,
-                         XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-        }
-        free(keycode_array);
-        keybinding_t *binding = keybinding_init(keybinding_alloc());
+
+    if (!keycode_array)
+        return;
+    while ((keycode = keycode_array[i++]) != XCB_NO_SYMBOL)
+        key_table_set(keycode, binding->mod_mask, binding->scm_proc);
+    free(keycode_array);
+}
+
+/* Bind proc to a key.  The grab is made at the end of the cycle, along
+ * with any others bound in the meantime.
+ */
+int bind_key(xcb_key_but_mask_t mod_mask, xcb_keysym_t keysym, SCM proc)
+{
+    keybinding_t key = { keysym, key_table_normalize(mod_mask), SCM_BOOL_F, NULL };
+    keybinding_t *binding;
+
+    /* binding the same key again replaces the old binding */
+    if (!(binding = sglib_keybinding_t_find_member(keybinding_list, &key))) {
+        binding = keybinding_init(keybinding_alloc());
         binding->keysym = keysym;
-        binding->mod_mask = mod_mask;
-        binding->scm_proc = proc;
+        binding->mod_mask = key.mod_mask;
+        binding->scm_proc = SCM_BOOL_F;
         sglib_keybinding_t_add(&keybinding_list, binding);
     }
-    xcb_ungrab_server(wm_conf.connection);
-    xcb_flush(wm_conf.connection);
+    /* the list keeps its own reference, so the table can be rebuilt */
+    scm_gc_protect_object(proc);
+    if (scm_is_true(binding->scm_proc))
+        scm_gc_unprotect_object(binding->scm_proc);
+    binding->scm_proc = proc;
+    key_table_add_binding(binding);
     return 1;
 }
 
-void auto_focus_pointer(void)
-{
-    xcb_query_pointer_cookie_t c = xcb_query_pointer_unchecked(wm_conf.connection,
-                                                               wm_conf.screen->root);
-    xcb_query_pointer_reply_t *reply = xcb_query_pointer_reply(wm_conf.connection,
-                                                               c,
-                                                               NULL);
-    if (reply) {
-        client_t *pointer_client = find_client(reply->child);
-        if (!wm_conf.pointer_window)  /* pointer_window hasn't been initialized yet */
-            wm_conf.pointer_window = reply->child;
-        if (pointer_client) {
-            if (wm_conf.pointer_window != pointer_client->window)
-                set_focus_client(pointer_client);
-            wm_conf.pointer_window = pointer_client->window;
-        }
-        free(reply);
-    }
+/* Rebuild the key table after the keyboard mapping changed.  Only the
+ * keycodes whose bindings actually moved get regrabbed.
+ */
+static void rebuild_key_table(void)
+{
+    keybinding_t *binding;
+
+    key_table_clear();
+    for (binding = keybinding_list; binding; binding = binding->next)
+        key_table_add_binding(binding);
+}
+
+/* Make the key grabs bindings made this cycle call for */
+static void apply_key_grabs(void)
+{
+    if (!key_table_grabs_pending())
+        return;
+    xcb_grab_server(wm_conf.connection);
+    key_table_apply_grabs(wm_conf.connection, wm_conf.screen->root);
+    xcb_ungrab_server(wm_conf.connection);
 }
 
 void init_conf_dir(void)
@@ -769,78 +1259,185 @@ void init_conf_dir(void)
     wm_conf.conf_dir_path = conf_dir_path;
 }
 
-static void event_task_repl_server(void)
+static event_watch_t x_watch;
+
+/* How long background work may run before input gets another look */
+#define BACKGROUND_SLICE_USEC 5000
+
+static void handle_x_event(xcb_generic_event_t *event)
 {
-    repl_server_step(wm_conf.repl_server);
+    /* replies the server sent before this event get handled first */
+    reply_queue_process_before(wm_conf.connection, event->full_sequence);
+    if (wm_conf.trace_x_events)
+        print_x_event(event);
+    xcb_event_handle(&wm_conf.event_handlers, event);
 }
 
-static void event_task_x_events(void)
+/* Called when the X connection is readable */
+static void event_task_x_events(void *data)
 {
-    xcb_generic_event_t *event;
     /* Handle all pending events */
-    while ((event = xcb_poll_for_event(wm_conf.connection))) {
-        if (wm_conf.trace_x_events)
-            print_x_event(event);
-        xcb_event_handle(&wm_conf.event_handlers, event);
-        free(event);
-        xcb_flush(wm_conf.connection);
-    }
+    event_queue_process(wm_conf.connection, false, &handle_x_event);
+    reply_queue_process(wm_conf.connection);
 }
 
-static void event_task_autofocus(void)
+/* Handle events xcb has already read off the socket, e.g. while it was
+ * waiting for a reply.  These will never make the descriptor readable
+ * again, so they have to be picked up before blocking.
+ */
+static void event_task_queued_x_events(void)
 {
-    auto_focus_pointer();
+    event_queue_process(wm_conf.connection, true, &handle_x_event);
+    reply_queue_process(wm_conf.connection);
 }
 
-static inline long timeval_usec_diff(struct timeval *begin, struct timeval *end)
+/* Whether the X server has sent something we haven't handled yet.
+ * Events xcb has already read (while waiting for a reply, say) are
+ * moved into the event queue batch so they aren't lost.
+ */
+static bool x_input_pending(void)
 {
-    return ((end->tv_sec - begin->tv_sec) * 1000000L + 
-            (long)(end->tv_usec - begin->tv_usec));
+    struct pollfd pfd;
+    xcb_generic_event_t *event;
+
+    if ((event = xcb_poll_for_queued_event(wm_conf.connection))) {
+        event_queue_push(event, &handle_x_event);
+        return true;
+    }
+    pfd.fd = xcb_get_file_descriptor(wm_conf.connection);
+    pfd.events = POLLIN;
+    return (poll(&pfd, 1, 0) > 0);
 }
 
 static void event_loop(void)
 {
-    /* Set up a circular list of task functions */
-    static const event_loop_task_func task_funcs[] = {
-        &event_task_repl_server,
-        &event_task_x_events,
-        &event_task_autofocus,
-    };
-    static const int task_func_count = sizeof(task_funcs) / sizeof(event_loop_task_func);
-    static const long usec_slice_size = 20000L;
-
-    int task_idx = 0;
-    struct timeval begin_time, end_time;
-    while (!wm_conf.stop) {
-        gettimeofday(&begin_time, NULL);
-        gettimeofday(&end_time, NULL);  /* Just making sure end_time is initialized */
+    event_loop_add_fd(&x_watch, xcb_get_file_descriptor(wm_conf.connection),
+                      &event_task_x_events, NULL);
+    event_loop_set_priority(&x_watch, EVENT_PRIORITY_INPUT);
 
-        /* Start as many of the tasks (max of once per task) as possible within 
-         * usec_slice_size microseconds.  The event loop blocks for the duration
-         * of each task.  The loop terminates after either all tasks have been
-         * completed or more time has elapsed than usec_slice_size microseconds.
+    while (!wm_conf.stop) {
+        event_task_queued_x_events();
+        run_pending_layout();
+        commit_client_geometry();
+        apply_key_grabs();
+        /* This is the only place requests are normally written to the
+         * server: everything issued during a dispatch cycle goes out in
+         * one write here, right before we block.
          */
-        int i;
-        for (i = 0; i < task_func_count; ++i) {
-            if (timeval_usec_diff(&begin_time, &end_time) > usec_slice_size)
-                break;
-            event_loop_task_func task_func = task_funcs[task_idx];
-            (*task_func)();
-            gettimeofday(&end_time, NULL);
-            if (++task_idx == task_func_count)
-                task_idx = 0;
+        xcb_flush(wm_conf.connection);
+        if (xcb_connection_has_error(wm_conf.connection)) {
+            fprintf(stderr, "lost connection to the X server\n");
+            break;
         }
-
-        /* Sleep for remaining microseconds of time slice, or 1 microsecond if the
-         * entire time slice was used.
+        /* Sleep until the X server or a REPL socket has something
+         * for us.  With background work (REPL evaluations) waiting,
+         * only check, and if nothing else is ready give the work one
+         * time slice, cut short as soon as X input arrives.
          */
-        long usleep_time = usec_slice_size - timeval_usec_diff(&begin_time, &end_time);
-        usleep(usleep_time > 0 ? usleep_time : 1);
+        if (!event_loop_has_tasks())
+            event_loop_dispatch(-1);
+        else if (event_loop_dispatch(0) == 0)
+            event_loop_run_tasks(BACKGROUND_SLICE_USEC, &x_input_pending);
     }
+
+    event_loop_remove(&x_watch);
+}
+
+static void handle_replayed_event(xcb_generic_event_t *event)
+{
+    /* recorded sequence numbers mean nothing to this connection, so
+     * unlike handle_x_event there is no ordering against replies */
+    if (wm_conf.trace_x_events)
+        print_x_event(event);
+    xcb_event_handle(&wm_conf.event_handlers, event);
+}
+
+/* Feed a recording through the normal dispatch path as fast as
+ * possible, treating each batch of events as one event loop cycle, and
+ * report how long it took.
+ */
+static int replay_events(const char *path)
+{
+    size_t count, i, j, batch_end;
+    xcb_generic_event_t **events = event_record_load(path, &count);
+    struct timespec begin, end;
+    double elapsed_ms;
+
+    if (!events)
+        return -1;
+
+    /* replayed events go through the same queue as live ones, so a
+     * recording started by init.scm would pick them up */
+    if (event_record_active()) {
+        fprintf(stderr, "replay: stopping the recording started by init.scm\n");
+        event_record_stop();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < count; i = batch_end) {
+        batch_end = (i + EVENT_BATCH_SIZE < count ? i + EVENT_BATCH_SIZE : count);
+        for (j = i; j < batch_end; ++j)
+            event_queue_push(events[j], &handle_replayed_event);
+        event_queue_dispatch(&handle_replayed_event);
+        reply_queue_process(wm_conf.connection);
+        run_pending_layout();
+        commit_client_geometry();
+        xcb_flush(wm_conf.connection);
+    }
+    /* let the server catch up, and run whatever it answered */
+    xcb_aux_sync(wm_conf.connection);
+    reply_queue_process(wm_conf.connection);
+    run_pending_layout();
+    commit_client_geometry();
+    xcb_aux_sync(wm_conf.connection);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed_ms = ((end.tv_sec - begin.tv_sec) * 1000.0 +
+                  (end.tv_nsec - begin.tv_nsec) / 1000000.0);
+    printf("replayed %zu events in %.3f ms (%.0f events/s), %lu folded\n",
+           count, elapsed_ms,
+           (elapsed_ms > 0 ? count * 1000.0 / elapsed_ms : 0.0),
+           event_queue_stats.folded);
+    free(events);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-R file | -r file]\n"
+            "  -R file  record all X events received to file\n"
+            "  -r file  replay the X events recorded in file as fast as possible, then exit\n",
+            prog);
 }
 
 int main(int argc, char **argv)
 {
+    char *record_path = NULL;
+    char *replay_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "R:r:h")) != -1) {
+        switch (opt) {
+        case 'R':
+            record_path = optarg;
+            break;
+        case 'r':
+            replay_path = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            exit(opt == 'h' ? 0 : 1);
+        }
+    }
+    /* replayed events go through the same queue as live ones, so they
+     * would end up in the new recording */
+    if (record_path && replay_path) {
+        fprintf(stderr, "%s: -R and -r can't be used together\n", argv[0]);
+        usage(argv[0]);
+        exit(1);
+    }
+
     xcb_connection_t *connection = xcb_connect(NULL, &wm_conf.default_screen_num);
     if (xcb_connection_has_error(connection)) {
         fprintf(stderr, "failed to open display\n");
@@ -851,6 +1448,12 @@ int main(int argc, char **argv)
     init_conf_dir();
     wm_conf.connection = connection;
 
+    if (event_loop_init() < 0)
+        exit(1);
+
+    if (record_path && event_record_start(record_path) < 0)
+        exit(1);
+
     const xcb_setup_t *setup = xcb_get_setup(connection);
     int num_screens = xcb_setup_roots_length(setup);
     fprintf(stderr, "init: num_screens = %d\n", num_screens);
@@ -881,6 +1484,7 @@ int main(int argc, char **argv)
     /* Process all errors in the queue if any */
     xcb_event_poll_for_event_loop(event_handlers);
 
+    atoms_init();
     scan_windows();
 
     xinerama_test();
@@ -890,6 +1494,7 @@ int main(int argc, char **argv)
 
     /* Allocate the key symbols */
     wm_conf.key_syms = xcb_key_symbols_alloc(connection);
+    init_lock_mask();
 
     fprintf(stderr, "selecting events from root window\n");
     const uint32_t root_win_event_mask = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
@@ -909,8 +1514,15 @@ int main(int argc, char **argv)
     wm_conf.repl_server = repl_server_init();
     load_init_scheme();
 
-    fprintf(stderr, "entering event loop\n");
-    event_loop();
+    if (replay_path) {
+        if (replay_events(replay_path) < 0)
+            exit(1);
+    }
+    else {
+        fprintf(stderr, "entering event loop\n");
+        event_loop();
+    }
+    event_record_stop();
 
     xcb_set_input_focus(connection, XCB_NONE, XCB_INPUT_FOCUS_POINTER_ROOT,
                         XCB_CURRENT_TIME);
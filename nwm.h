@@ -32,6 +32,7 @@
 #include <libguile.h>
 
 #include "event.h"
+#include "client-props.h"
 #include "sglib.h"
 
 /* Configuration data directory, relative to $HOME */
@@ -39,6 +40,14 @@
 
 typedef struct repl_server repl_server_t;
 
+/* How draw_border draws a border */
+typedef enum border_style {
+    /* the window's own X border (border pixel and border width) */
+    BORDER_STYLE_SERVER,
+    /* a rectangle painted on the root window behind the client */
+    BORDER_STYLE_ROOT
+} border_style_t;
+
 typedef struct nwm {
     xcb_connection_t *connection;
     xcb_event_handlers_t event_handlers;
@@ -51,10 +60,22 @@ typedef struct nwm {
     bool trace_x_events;
     repl_server_t *repl_server;
     xcb_window_t pointer_window;
+    bool layout_dirty;
+    border_style_t border_style;
+    /* the client we last gave the focus to or saw get it, and the
+     * sequence number of our last SetInputFocus */
+    struct client *focus;
+    uint32_t focus_sequence;
+    /* number of times we have blocked waiting for a reply */
+    unsigned long round_trips;
 } nwm_t;
 
 extern nwm_t wm_conf;
 
+/* Events selected on every managed client window */
+#define CLIENT_EVENT_MASK (XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_FOCUS_CHANGE | \
+                           XCB_EVENT_MASK_PROPERTY_CHANGE)
+
 typedef struct rect {
     int16_t x;
     int16_t y;
@@ -63,16 +84,38 @@ typedef struct rect {
 } rect_t;
 
 typedef struct client {
-    rect_t rect;
     xcb_window_t window;
-    uint16_t border_width;
+    /* map state as of our last map/unmap request or the server's last
+     * word on it, whichever is newer */
+    bool mapped;
+    uint32_t map_sequence;
+    /* where the client lives in the client pool */
+    uint32_t slot;
+    uint32_t generation;
+    /* the one Scheme object for this client, or #f until needed */
+    SCM smob;
+    /* neighbours in client_list */
+    struct client *prev;
     struct client *next;
+    /* the border pixel last set on the window, if border_color_set */
+    uint32_t border_color;
+    bool border_color_set;
+    /* the border last painted for it on the root, if root_border_painted */
+    xcb_rectangle_t root_border;
+    uint16_t root_border_width;
+    bool root_border_painted;
+    /* cached window properties */
+    client_props_t props;
 } client_t;
 
+/* Managed clients in order, as an intrusive doubly linked list */
 extern client_t *client_list;
-#define COMPARE_CLIENT(x,y) (x->window - y->window)
-SGLIB_DEFINE_LIST_PROTOTYPES(client_t, COMPARE_CLIENT, next)
+extern client_t *client_list_tail;
+extern int client_count;
 
+/* A key binding as it was made.  Dispatch goes through the key table
+ * (key-table.h), which is built from these.
+ */
 typedef struct keybinding {
     xcb_keysym_t keysym;
     xcb_key_but_mask_t mod_mask;
@@ -81,15 +124,26 @@ typedef struct keybinding {
 } keybinding_t;
 
 extern keybinding_t *keybinding_list;
-#define COMPARE_KEYBINDING(x,y) (x->keysym - y->keysym)
+#define COMPARE_KEYBINDING(x,y) \
+    ((x)->keysym != (y)->keysym ? (int)((x)->keysym - (y)->keysym) \
+                                : (int)(x)->mod_mask - (int)(y)->mod_mask)
 SGLIB_DEFINE_LIST_PROTOTYPES(keybinding_t, COMPARE_KEYBINDING, next)
 
-void update_client_geometry(client_t *);
 void map_client(client_t *);
 void unmap_client(client_t *);
 bool is_mapped(client_t *);
 void destroy_client(client_t *);
+void unmanage_client(client_t *);
 xcb_atom_t get_atom(char *);
+void client_list_add(client_t *);
+void client_list_remove(client_t *);
+void client_list_move_before(client_t *, client_t *);
+void client_list_move_after(client_t *, client_t *);
+void client_list_move_to_front(client_t *);
+void client_list_swap(client_t *, client_t *);
+void client_list_reverse(void);
+client_t *client_next(client_t *);
+client_t *client_prev(client_t *);
 client_t *find_client(xcb_window_t);
 xcb_keysym_t get_keysym(char *);
 int bind_key(xcb_key_but_mask_t, xcb_keysym_t, SCM);
@@ -97,6 +151,11 @@ void get_client_name(client_t *, char *);
 client_t *get_focus_client(void);
 void set_focus_client(client_t *);
 void draw_border(client_t *, uint32_t, int);
+void draw_borders(client_t **, int, uint32_t, int);
 void clear_root(void);
+void set_border_style(border_style_t);
+void flush_requests(void);
+void sync_requests(void);
+void request_layout(void);
 
 #endif
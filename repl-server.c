@@ -24,7 +24,6 @@
 #include <string.h>
 #include <sys/types.h>
 #include <errno.h>
-#include <sys/select.h>
 #include <fcntl.h>
 #include <libguile.h>
 #include "nwm.h"
@@ -68,6 +67,7 @@ repl_conn_t *repl_conn_alloc(void)
 repl_conn_t *repl_conn_init(repl_conn_t *conn)
 {
     bzero(conn, sizeof(repl_conn_t));
+    conn->eval_state = SCM_BOOL_F;
     io_buffer_reset(&conn->read_buf);
     io_buffer_reset(&conn->write_buf);
     return conn;
@@ -75,6 +75,10 @@ repl_conn_t *repl_conn_init(repl_conn_t *conn)
 
 void repl_conn_free(repl_conn_t *conn)
 {
+    event_loop_cancel_task(&conn->eval_task);
+    if (scm_is_true(conn->eval_state))
+        scm_gc_unprotect_object(conn->eval_state);
+    close(conn->sockfd);
     free(conn);
 }
 
@@ -274,22 +278,69 @@ void str_exception_param(SCM param, char *param_str){
     scm_dynwind_free(str);
 }
 
-void repl_conn_eval_lisp(repl_conn_t *conn)
+typedef struct repl_eval {
+    SCM port;
+    bool failed;
+} repl_eval_t;
+
+/* Read the next expression from the port and evaluate it, or return
+ * the end-of-file object if there are none left.
+ */
+static SCM eval_next_lisp(void *data)
 {
-    scm_set_current_output_port(conn->port);
+    SCM form = scm_read(((repl_eval_t *)data)->port);
+    if (SCM_EOF_OBJECT_P(form))
+        return form;
+    return scm_eval(form, scm_current_module());
+}
 
-    SCM write_scm = scm_c_eval_string("write");
- 
+static SCM handle_repl_eval_error(void *data, SCM key, SCM parameters)
+{
+    ((repl_eval_t *)data)->failed = true;
+    return handle_lisp_error(NULL, key, parameters);
+}
+
+/* Take everything read so far as the expressions to evaluate.  They are
+ * evaluated one per repl_conn_eval_step(), as background work, so a
+ * long script sent over the socket can't hold up key presses.
+ */
+static void repl_conn_begin_eval(repl_conn_t *conn)
+{
     size_t lisp_len = (conn->read_buf.end_p - conn->read_buf.begin_p);
-    fprintf(stderr, "repl_conn_eval_lisp:\n    lisp_len = %ld\n", lisp_len);
-    char *lisp = malloc(lisp_len + 1);
-    memcpy(lisp, conn->read_buf.begin_p, lisp_len);
-    lisp[lisp_len] = 0;
+    fprintf(stderr, "repl_conn_begin_eval:\n    lisp_len = %ld\n", lisp_len);
+    SCM lisp = scm_from_locale_stringn(conn->read_buf.begin_p, lisp_len);
+    io_buffer_reset(&conn->read_buf);
+
+    /* (port . result so far), kept from the GC while we hold on to it */
+    conn->eval_state = scm_cons(scm_open_input_string(lisp), SCM_UNSPECIFIED);
+    scm_gc_protect_object(conn->eval_state);
+}
 
-    SCM res = scm_c_catch(SCM_BOOL_T, /* applies to all exception types */
-                          eval_lisp, lisp,
-                          handle_lisp_error, NULL,
-                          NULL, NULL);
+/* Evaluate the next expression.  Returns true if there may be more. */
+static bool repl_conn_eval_step(repl_conn_t *conn)
+{
+    repl_eval_t eval;
+    SCM res;
+
+    eval.port = scm_car(conn->eval_state);
+    eval.failed = false;
+    scm_set_current_output_port(conn->port);
+    res = scm_c_catch(SCM_BOOL_T, /* applies to all exception types */
+                      eval_next_lisp, &eval,
+                      handle_repl_eval_error, &eval,
+                      NULL, NULL);
+    if (SCM_EOF_OBJECT_P(res))
+        return false;
+    scm_set_cdr_x(conn->eval_state, res);
+    /* like scm_c_eval_string, give up on the rest after an error */
+    return !eval.failed;
+}
+
+/* Put the result of the last expression in the write buffer */
+static void repl_conn_end_eval(repl_conn_t *conn)
+{
+    SCM write_scm = scm_c_eval_string("write");
+    SCM res = scm_cdr(conn->eval_state);
 
     char *res_str = "\0";
     if (res != SCM_UNSPECIFIED) {
@@ -305,14 +356,23 @@ void repl_conn_eval_lisp(repl_conn_t *conn)
         io_buffer_write(&conn->write_buf, res_str, strlen(res_str)+1);
     }
     else {
-        /* write the string without null byte */
-        io_buffer_write(&conn->write_buf, res_str, strlen(res_str));
+        /* write the string without null byte, cut short if it doesn't
+         * fit (results like (event-stats) can get long) */
+        size_t res_len = strlen(res_str);
+        size_t avail = io_buffer_available(&conn->write_buf);
+        /* leave room for the newline and null byte; output written to
+         * the port during the evaluation may have used most of it */
+        avail = (avail >= 2 ? avail - 2 : 0);
+        if (avail > 0)
+            io_buffer_write(&conn->write_buf, res_str, (res_len < avail ? res_len : avail));
         /* write newline and null byte */
-        io_buffer_write(&conn->write_buf, "\n", 2);
+        if (io_buffer_write(&conn->write_buf, "\n", 2) < 0)
+            fprintf(stderr, "    REPL write buffer full, result dropped\n");
+        free(res_str);
     }
 
-    io_buffer_reset(&conn->read_buf);
-    free(lisp);
+    scm_gc_unprotect_object(conn->eval_state);
+    conn->eval_state = SCM_BOOL_F;
 }
 
 void load_init_scheme(void)
@@ -362,22 +422,58 @@ static void repl_server_socket_init(repl_server_t *server)
         perror("fcntl error");
 }
 
-repl_server_t *repl_server_init(void)
+static void repl_server_handle_conn(void *);
+
+static void repl_server_remove_conn(repl_conn_t *conn)
 {
-    repl_server_t *server = (repl_server_t *)malloc(sizeof(repl_server_t));
-    memset(server, 0, sizeof(repl_server_t));
-    repl_server_socket_init(server);
-    scm_with_guile(&init_scheme, NULL);
-    return server;
+    fprintf(stderr, "removing connection, socket %d\n", conn->sockfd);
+    event_loop_remove(&conn->watch);
+    sglib_repl_conn_t_delete(&wm_conf.repl_server->conn_list, conn);
+    repl_conn_free(conn);
+}
+
+/* Background task evaluating a request, one expression at a time */
+static bool repl_conn_eval_task(void *data)
+{
+    repl_conn_t *conn = (repl_conn_t *)data;
+
+    if (repl_conn_eval_step(conn))
+        return true;
+    repl_conn_end_eval(conn);
+    repl_conn_write(conn);
+    /* ready for the next request */
+    if (event_loop_add_fd(&conn->watch, conn->sockfd, &repl_server_handle_conn, conn) < 0)
+        repl_server_remove_conn(conn);
+    return false;
+}
+
+/* Called when a client connection is readable */
+static void repl_server_handle_conn(void *data)
+{
+    repl_conn_t *conn = (repl_conn_t *)data;
+    ssize_t n;
+
+    fprintf(stderr, "read available for socket %d\n", conn->sockfd);
+    n = repl_conn_read(conn);
+    if (n == 0 || n == -1)
+        repl_server_remove_conn(conn);
+    else if (n > 0) {
+        /* we read something - evaluate it when there's time, and stop
+         * reading until it has been answered */
+        event_loop_remove(&conn->watch);
+        repl_conn_begin_eval(conn);
+        event_loop_queue_task(&conn->eval_task, &repl_conn_eval_task, conn);
+    }
 }
 
-static void repl_server_accept_conn(repl_server_t *server)
+static void repl_server_accept_conn(void *data)
 {
+    repl_server_t *server = (repl_server_t *)data;
     int sockfd;
     struct sockaddr_un addr;
     socklen_t len = sizeof(addr);
     if ((sockfd = accept(server->sockfd, (struct sockaddr *)&addr, &len)) < 0) {
-        if (errno != EINTR)
+        if (errno != EINTR && errno != EAGAIN)
             perror("accept error");
     }
     else {
@@ -387,74 +483,20 @@ static void repl_server_accept_conn(repl_server_t *server)
         memcpy(&conn->addr, &addr, sizeof(struct sockaddr_un));
         conn->port = io_buffer_to_port(&conn->write_buf);
         sglib_repl_conn_t_add(&server->conn_list, conn);
+        if (event_loop_add_fd(&conn->watch, sockfd, &repl_server_handle_conn, conn) < 0) {
+            sglib_repl_conn_t_delete(&server->conn_list, conn);
+            repl_conn_free(conn);
+        }
     }
 }
 
-void repl_server_step(repl_server_t *server)
+repl_server_t *repl_server_init(void)
 {
-    fd_set rset, wset;
-    int val, maxfd;
-    struct timeval timeout;    
-
-    /* timeout of zero for select because we want no blocking */
-    bzero(&timeout, sizeof(timeout));
-
-    FD_ZERO(&rset);
-    FD_ZERO(&wset);
-    /* monitor server socket for read availability, indicating that there is a
-       pending client connection to accept */
-    FD_SET(server->sockfd, &rset);
-
-    /* monitor all client connections for read/write availability */
-    maxfd = server->sockfd;
-    repl_conn_t *conn = server->conn_list;
-    while (conn) {
-        FD_SET(conn->sockfd, &rset);
-        FD_SET(conn->sockfd, &wset);
-        if (conn->sockfd > maxfd)
-            maxfd = conn->sockfd;
-        conn = conn->next;
-    }
-
-    val = select(maxfd + 1, &rset, &wset, NULL, &timeout);
-    if (val < 0) {
-        perror("select error");
-        return;
-    }
-
-    if (FD_ISSET(server->sockfd, &rset))
-        repl_server_accept_conn(server);
-
-    /* Process any client connections that are available for read/write */
-    conn = server->conn_list;
-    repl_conn_t *delete_list = NULL;
-    while (conn) {
-        ssize_t n = 0;
-        if (FD_ISSET(conn->sockfd, &rset)) {
-            fprintf(stderr, "read available for socket %d\n", 
-                    conn->sockfd);
-            if ((n = repl_conn_read(conn)) == 0) {
-                fprintf(stderr, "removing connection, socket %d\n", conn->sockfd);
-                sglib_repl_conn_t_add(&delete_list, conn);
-            }
-            else if (n > 0) {
-                /* we read something - try to evaluate lisp */
-                repl_conn_eval_lisp(conn);
-            }
-        }
-
-        if (FD_ISSET(conn->sockfd, &wset)) {
-            if (n > 0) { /* we read something */
-                repl_conn_write(conn);
-            }
-        }
-        conn = conn->next;
-    }
-
-    conn = delete_list;
-    while (conn) {
-        sglib_repl_conn_t_delete(&server->conn_list, conn);
-        repl_conn_free(conn);
-        conn = conn->next;
-    }
+    repl_server_t *server = (repl_server_t *)malloc(sizeof(repl_server_t));
+    memset(server, 0, sizeof(repl_server_t));
+    repl_server_socket_init(server);
+    scm_with_guile(&init_scheme, NULL);
+    /* a readable listening socket means a client is waiting to be accepted */
+    event_loop_add_fd(&server->watch, server->sockfd, &repl_server_accept_conn, server);
+    return server;
 }
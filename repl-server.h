@@ -25,6 +25,8 @@
 #include <sys/un.h>
 #include <libguile.h>
 
+#include "event-loop.h"
+
 #define BUFSIZE 4096
 
 typedef struct io_buffer {
@@ -39,6 +41,10 @@ typedef struct repl_conn {
     io_buffer_t read_buf;
     io_buffer_t write_buf;
     SCM port;
+    event_watch_t watch;
+    /* request being evaluated, or #f */
+    SCM eval_state;
+    event_task_t eval_task;
     struct repl_conn *next;
 } repl_conn_t;
 
@@ -46,13 +52,13 @@ typedef struct repl_server {
     int sockfd;
     struct sockaddr_un addr;
     repl_conn_t *conn_list;
+    event_watch_t watch;
 } repl_server_t;
 
 #define COMPARE_REPL_CONN(x,y) (x->sockfd - y->sockfd)
 SGLIB_DEFINE_LIST_PROTOTYPES(repl_conn_t, COMPARE_REPL_CONN, next)
 
 repl_server_t *repl_server_init(void);
-void repl_server_step(repl_server_t *server);
 void init_io_buffer_ports(void);
 void load_init_scheme(void);
 void str_exception_param(SCM, char *);
@@ -0,0 +1,121 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+
+#include "reply-queue.h"
+
+typedef struct pending_reply {
+    unsigned int sequence;
+    reply_func func;
+    void *data;
+} pending_reply_t;
+
+/* Ring buffer of outstanding requests, in the order they were sent.
+ * The server answers requests in order, so only the head can be the
+ * next one to complete.
+ */
+static pending_reply_t *queue = NULL;
+static size_t queue_cap = 0;
+static size_t queue_head = 0;
+static size_t queue_len = 0;
+
+static void reply_queue_grow(void)
+{
+    size_t new_cap = (queue_cap ? queue_cap * 2 : 64);
+    pending_reply_t *new_queue = (pending_reply_t *)malloc(new_cap * sizeof(pending_reply_t));
+    size_t i;
+
+    if (!new_queue) {
+        perror("reply queue allocation failed");
+        exit(1);
+    }
+    for (i = 0; i < queue_len; ++i)
+        new_queue[i] = queue[(queue_head + i) % queue_cap];
+    free(queue);
+    queue = new_queue;
+    queue_cap = new_cap;
+    queue_head = 0;
+}
+
+/* Register func to be called with the reply to the request with the
+ * given sequence number (cookie.sequence).  The request must be a
+ * checked one so that errors come back here rather than as events.
+ */
+void reply_queue_push(unsigned int sequence, reply_func func, void *data)
+{
+    pending_reply_t *entry;
+
+    if (queue_len == queue_cap)
+        reply_queue_grow();
+    entry = &queue[(queue_head + queue_len) % queue_cap];
+    entry->sequence = sequence;
+    entry->func = func;
+    entry->data = data;
+    ++queue_len;
+}
+
+static int reply_queue_run(xcb_connection_t *c, bool bounded, uint32_t sequence)
+{
+    int handled = 0;
+
+    while (queue_len > 0) {
+        pending_reply_t entry = queue[queue_head];
+        void *reply = NULL;
+        xcb_generic_error_t *error = NULL;
+
+        /* sequence numbers wrap, so compare the difference */
+        if (bounded && (int32_t)(sequence - entry.sequence) < 0)
+            break;
+        if (!xcb_poll_for_reply(c, entry.sequence, &reply, &error))
+            break;
+
+        /* pop before calling, the callback may push new requests */
+        queue_head = (queue_head + 1) % queue_cap;
+        --queue_len;
+
+        entry.func(reply, error, entry.data);
+        free(reply);
+        free(error);
+        ++handled;
+    }
+    return handled;
+}
+
+/* Run the callbacks of every request whose reply has arrived */
+int reply_queue_process(xcb_connection_t *c)
+{
+    return reply_queue_run(c, false, 0);
+}
+
+/* Like reply_queue_process, but stop at requests sent after the given
+ * sequence number.  Called with an event's sequence number before
+ * handling it, so replies and events are seen in the order the server
+ * generated them.
+ */
+int reply_queue_process_before(xcb_connection_t *c, uint32_t sequence)
+{
+    return reply_queue_run(c, true, sequence);
+}
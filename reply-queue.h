@@ -0,0 +1,37 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __REPLY_QUEUE_H__
+#define __REPLY_QUEUE_H__
+
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/* Continuation for a request sent without waiting for its reply.
+ * Exactly one of reply and error is set.  Both are freed by the queue
+ * after the callback returns.
+ */
+typedef void (*reply_func)(void *reply, xcb_generic_error_t *error, void *data);
+
+void reply_queue_push(unsigned int, reply_func, void *);
+int reply_queue_process(xcb_connection_t *);
+int reply_queue_process_before(xcb_connection_t *, uint32_t);
+
+#endif
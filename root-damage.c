@@ -0,0 +1,121 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "root-damage.h"
+
+/* The damaged area as a list of rectangles, which may overlap */
+static xcb_rectangle_t pieces[ROOT_DAMAGE_MAX];
+static int pieces_len = 0;
+/* set when the damage no longer fits in pieces */
+static bool everything = false;
+
+static void add_piece(int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0 || everything)
+        return;
+    if (pieces_len == ROOT_DAMAGE_MAX) {
+        everything = true;
+        return;
+    }
+    pieces[pieces_len].x = x;
+    pieces[pieces_len].y = y;
+    pieces[pieces_len].width = width;
+    pieces[pieces_len].height = height;
+    ++pieces_len;
+}
+
+void root_damage_add(const xcb_rectangle_t *rect)
+{
+    add_piece(rect->x, rect->y, rect->width, rect->height);
+}
+
+/* Give up on tracking and clear the whole root next time */
+void root_damage_add_all(void)
+{
+    everything = true;
+}
+
+/* Remove rect from the damaged area.  Each piece it overlaps is
+ * replaced by the (up to four) parts of it outside rect.
+ */
+void root_damage_subtract(const xcb_rectangle_t *rect)
+{
+    int rx1 = rect->x, ry1 = rect->y;
+    int rx2 = rx1 + rect->width, ry2 = ry1 + rect->height;
+    int px1, py1, px2, py2, top, bottom;
+    int i, n = pieces_len;
+    xcb_rectangle_t piece;
+
+    if (everything)
+        return;
+    for (i = 0; i < n; ) {
+        piece = pieces[i];
+        px1 = piece.x;
+        py1 = piece.y;
+        px2 = px1 + piece.width;
+        py2 = py1 + piece.height;
+        if (rx1 >= px2 || rx2 <= px1 || ry1 >= py2 || ry2 <= py1) {
+            ++i;
+            continue;
+        }
+        /* drop the piece, keeping the order of the unvisited ones */
+        pieces[i] = pieces[n - 1];
+        pieces[n - 1] = pieces[pieces_len - 1];
+        --pieces_len;
+        --n;
+
+        top = (ry1 > py1 ? ry1 : py1);
+        bottom = (ry2 < py2 ? ry2 : py2);
+        /* above, below, then left and right of the overlap */
+        add_piece(px1, py1, px2 - px1, top - py1);
+        add_piece(px1, bottom, px2 - px1, py2 - bottom);
+        add_piece(px1, top, rx1 - px1, bottom - top);
+        add_piece(rx2, top, px2 - rx2, bottom - top);
+        if (everything)
+            return;
+    }
+}
+
+/* Clear the damaged area of root (without generating Expose events)
+ * and forget it.  Returns the number of ClearArea requests sent.
+ */
+int root_damage_clear(xcb_connection_t *c, xcb_window_t root)
+{
+    int i, sent;
+
+    if (everything) {
+        /* a width and height of zero mean the whole window */
+        xcb_clear_area(c, 0, root, 0, 0, 0, 0);
+        sent = 1;
+    }
+    else {
+        for (i = 0; i < pieces_len; ++i)
+            xcb_clear_area(c, 0, root, pieces[i].x, pieces[i].y,
+                           pieces[i].width, pieces[i].height);
+        sent = pieces_len;
+    }
+    pieces_len = 0;
+    everything = false;
+    return sent;
+}
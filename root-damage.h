@@ -0,0 +1,40 @@
+/* nwm - a programmable window manager
+ * Copyright (C) 2013  Brandon Invergo
+ * Copyright (C) 2010-2012  Nathan Sullivan
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
+
+#ifndef __ROOT_DAMAGE_H__
+#define __ROOT_DAMAGE_H__
+
+#include <xcb/xcb.h>
+
+/* Areas of the root window whose painting is stale and has to be
+ * cleared back to the background.  Areas that are about to be painted
+ * over again can be subtracted, so only what was actually exposed gets
+ * cleared.
+ */
+
+/* Past this many pieces the whole root is cleared instead */
+#define ROOT_DAMAGE_MAX 64
+
+void root_damage_add(const xcb_rectangle_t *);
+void root_damage_subtract(const xcb_rectangle_t *);
+void root_damage_add_all(void);
+int root_damage_clear(xcb_connection_t *, xcb_window_t);
+
+#endif
@@ -28,6 +28,12 @@
 #include "nwm.h"
 #include "repl-server.h"
 #include "scheme.h"
+#include "event-queue.h"
+#include "event-record.h"
+#include "client-pool.h"
+#include "client-geometry.h"
+#include "client-props.h"
+#include "atoms.h"
 
 static SCM mark_client(SCM client_smob)
 {
@@ -41,10 +47,14 @@ static size_t free_client(SCM client_smob)
 
 static int print_client(SCM client_smob, SCM port, scm_print_state *pstate)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client_t *client = client_pool_get(SCM_SMOB_DATA(client_smob),
+                                       SCM_SMOB_DATA_2(client_smob));
 
     scm_puts("#<client ", port);
-    scm_display(scm_from_unsigned_integer(client->window), port);
+    if (client)
+        scm_display(scm_from_unsigned_integer(client->window), port);
+    else
+        scm_puts("destroyed", port);
     scm_puts(">", port);
 
     /* success */
@@ -53,10 +63,9 @@ static int print_client(SCM client_smob, SCM port, scm_print_state *pstate)
 
 static SCM equalp_client(SCM client_smob1, SCM client_smob2)
 {
-    client_t *client1 = (client_t *)SCM_SMOB_DATA(client_smob1);
-    client_t *client2 = (client_t *)SCM_SMOB_DATA(client_smob2);
-
-    if (client1->window == client2->window)
+    /* the same slot and generation is the same client, destroyed or not */
+    if (SCM_SMOB_DATA(client_smob1) == SCM_SMOB_DATA(client_smob2) &&
+        SCM_SMOB_DATA_2(client_smob1) == SCM_SMOB_DATA_2(client_smob2))
         return SCM_BOOL_T;
     return SCM_BOOL_F;
 }
@@ -64,41 +73,79 @@ static SCM equalp_client(SCM client_smob1, SCM client_smob2)
 
 static void init_client_type(void)
 {
-    client_tag = scm_make_smob_type("client", sizeof(client_t));
+    /* the smob only names a client pool slot, it owns no memory */
+    client_tag = scm_make_smob_type("client", 0);
     scm_set_smob_mark(client_tag, mark_client);
     scm_set_smob_free(client_tag, free_client);
     scm_set_smob_print(client_tag, print_client);
     scm_set_smob_equalp(client_tag, equalp_client);
 }
 
+/* The Scheme object naming a client, or unspecified for no client.
+ * Each client has just one, made the first time it is asked for and
+ * kept alive until the client is freed, so hooks don't allocate and
+ * eq? works on clients.
+ */
+SCM client_to_scm(client_t *client)
+{
+    if (!client)
+        return SCM_UNSPECIFIED;
+    if (scm_is_false(client->smob)) {
+        SCM_NEWSMOB2(client->smob, client_tag, client->slot, client->generation);
+        scm_gc_protect_object(client->smob);
+    }
+    return client->smob;
+}
+
+/* Let go of a client's Scheme object before the client is freed.  Any
+ * copies Scheme still holds name a dead generation from then on.
+ */
+void client_release_scm(client_t *client)
+{
+    if (scm_is_false(client->smob))
+        return;
+    scm_gc_unprotect_object(client->smob);
+    client->smob = SCM_BOOL_F;
+}
+
+/* The client a Scheme object names.  Throws an error if the client has
+ * since been destroyed, rather than handing back whatever reuses its
+ * memory now.
+ */
+client_t *scm_to_client(SCM client_smob)
+{
+    client_t *client;
+    scm_assert_smob_type(client_tag, client_smob);
+    client = client_pool_get(SCM_SMOB_DATA(client_smob), SCM_SMOB_DATA_2(client_smob));
+    if (!client)
+        scm_misc_error(NULL, "client ~S has been destroyed", scm_list_1(client_smob));
+    return client;
+}
+
 static SCM scm_move_client(SCM client_smob, SCM x, SCM y)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    client->rect.x = scm_to_int16(x);
-    client->rect.y = scm_to_int16(y);
-    update_client_geometry(client);
+    client_t *client = scm_to_client(client_smob);
+    client_geometry_set_position(client, scm_to_int16(x), scm_to_int16(y));
     return SCM_UNSPECIFIED;
 }
 
 static SCM scm_resize_client(SCM client_smob, SCM width, SCM height)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    client->rect.width = scm_to_uint16(width);
-    client->rect.height = scm_to_uint16(height);
-    update_client_geometry(client);
+    client_t *client = scm_to_client(client_smob);
+    client_geometry_set_size(client, scm_to_uint16(width), scm_to_uint16(height));
     return SCM_UNSPECIFIED;
 }
 
 static SCM scm_map_client(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client_t *client = scm_to_client(client_smob);
     map_client(client);
     return SCM_UNSPECIFIED;
 }
 
 static SCM scm_unmap_client(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client_t *client = scm_to_client(client_smob);
     unmap_client(client);
     return SCM_UNSPECIFIED;
 }
@@ -107,7 +154,7 @@ static SCM scm_is_mapped(SCM client_smob)
 {
     /* if (scm_equal_p(client_smob, SCM_UNSPECIFIED)) */
     /*     return SCM_BOOL_F; */
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client_t *client = scm_to_client(client_smob);
     if (is_mapped(client))
         return SCM_BOOL_T;
     else
@@ -116,33 +163,40 @@ static SCM scm_is_mapped(SCM client_smob)
 
 static SCM scm_destroy_client(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client_t *client = scm_to_client(client_smob);
     destroy_client(client);
     return SCM_UNSPECIFIED;
 }
 
 static SCM scm_client_x(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    return scm_from_signed_integer(client->rect.x);
+    client_t *client = scm_to_client(client_smob);
+    return scm_from_signed_integer(client_geometry_rect(client).x);
 }
 
 static SCM scm_client_y(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    return scm_from_signed_integer(client->rect.y);
+    client_t *client = scm_to_client(client_smob);
+    return scm_from_signed_integer(client_geometry_rect(client).y);
 }
 
 static SCM scm_client_width(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    return scm_from_unsigned_integer(client->rect.width);
+    client_t *client = scm_to_client(client_smob);
+    return scm_from_unsigned_integer(client_geometry_rect(client).width);
 }
 
 static SCM scm_client_height(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    return scm_from_unsigned_integer(client->rect.height);
+    client_t *client = scm_to_client(client_smob);
+    return scm_from_unsigned_integer(client_geometry_rect(client).height);
+}
+
+/* The X border width the client has been given, drawn outside its size */
+static SCM scm_client_border_width(SCM client_smob)
+{
+    client_t *client = scm_to_client(client_smob);
+    return scm_from_unsigned_integer(client_geometry_border_width(client));
 }
 
 static SCM scm_clear(void)
@@ -151,9 +205,98 @@ static SCM scm_clear(void)
     return SCM_UNSPECIFIED;
 }
 
+static SCM scm_request_layout(void)
+{
+    request_layout();
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scm_flush(void)
+{
+    flush_requests();
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scm_sync(void)
+{
+    sync_requests();
+    return SCM_UNSPECIFIED;
+}
+
+/* The number of requests sent to the server so far (counting the no-op
+ * used to find out) and the number of round trips made waiting for
+ * replies.
+ */
+static SCM scm_x_request_stats(void)
+{
+    xcb_void_cookie_t cookie = xcb_no_operation(wm_conf.connection);
+    return scm_list_2(scm_cons(scm_from_locale_symbol("requests"),
+                               scm_from_uint(cookie.sequence)),
+                      scm_cons(scm_from_locale_symbol("round-trips"),
+                               scm_from_ulong(wm_conf.round_trips)));
+}
+
+/* The X atom for a name, interned on first use */
+static SCM scm_atom(SCM name)
+{
+    xcb_atom_t atom;
+    char *c_name;
+
+    scm_dynwind_begin(0);
+    c_name = scm_to_locale_string(name);
+    scm_dynwind_free(c_name);
+    atom = atoms_intern(c_name);
+    scm_dynwind_end();
+    return scm_from_uint32(atom);
+}
+
+/* Draw the same border around every client in a list in one go */
+static SCM scm_draw_borders_x(SCM client_list, SCM color, SCM width)
+{
+    long len = scm_ilength(client_list);
+    client_t **clients;
+    uint32_t color_uint = 0x6CA0A3;
+    int width_int = 1;
+    long i;
+
+    SCM_ASSERT(len >= 0, client_list, SCM_ARG1, "draw-borders!");
+    if (scm_is_integer(color))
+        color_uint = scm_to_uint32(color);
+    if (scm_is_integer(width))
+        width_int = scm_to_int(width);
+    /* scm_to_client throws for a destroyed client */
+    scm_dynwind_begin(0);
+    clients = (client_t **)scm_malloc((len ? len : 1) * sizeof(client_t *));
+    scm_dynwind_free(clients);
+    for (i = 0; i < len; ++i, client_list = scm_cdr(client_list))
+        clients[i] = scm_to_client(scm_car(client_list));
+    draw_borders(clients, len, color_uint, width_int);
+    scm_dynwind_end();
+    return SCM_UNSPECIFIED;
+}
+
+/* The current border style, 'server or 'root */
+static SCM scm_border_style(void)
+{
+    if (wm_conf.border_style == BORDER_STYLE_ROOT)
+        return scm_from_locale_symbol("root");
+    return scm_from_locale_symbol("server");
+}
+
+static SCM scm_set_border_style_x(SCM style)
+{
+    if (scm_is_eq(style, scm_from_locale_symbol("server")))
+        set_border_style(BORDER_STYLE_SERVER);
+    else if (scm_is_eq(style, scm_from_locale_symbol("root")))
+        set_border_style(BORDER_STYLE_ROOT);
+    else
+        scm_wrong_type_arg("set-border-style!", 1, style);
+    return SCM_UNSPECIFIED;
+}
+
 static SCM scm_draw_border(SCM client_smob, SCM color, SCM width)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client_t *client = scm_to_client(client_smob);
     uint32_t color_uint;
     int width_int;
     if (scm_is_integer(color))
@@ -176,69 +319,71 @@ static SCM scm_nwm_stop(void)
 
 static SCM scm_count_clients(void)
 {
-    int len = sglib_client_t_len(client_list);
-    return scm_from_unsigned_integer(len);
+    return scm_from_unsigned_integer(client_count);
 }
 
 static SCM scm_all_clients(void)
 {
     SCM clients = SCM_EOL;
-    SCM smob;
     client_t *client = client_list;
+    /* cons up the list backwards and reverse it in place, rather than
+     * copying it to append each client */
     while (client) {
-        SCM_NEWSMOB(smob, client_tag, client);
-        clients = scm_append(scm_list_2(clients, scm_list_1(smob)));
+        clients = scm_cons(client_to_scm(client), clients);
         client = client->next;
     }
-    return clients;
+    return scm_reverse_x(clients, SCM_EOL);
 }
 
 static SCM scm_visible_clients(void)
 {
     SCM clients = SCM_EOL;
-    SCM smob;
     client_t *client = client_list;
     while (client) {
-        if (is_mapped(client)) {
-            SCM_NEWSMOB(smob, client_tag, client);
-            clients = scm_append(scm_list_2(clients, scm_list_1(smob)));
-        }
+        if (is_mapped(client))
+            clients = scm_cons(client_to_scm(client), clients);
         client = client->next;
     }
-    return clients;
+    return scm_reverse_x(clients, SCM_EOL);
 }
 
 static SCM scm_client_list_reverse(void)
 {
-    sglib_client_t_reverse(&client_list);
+    client_list_reverse();
     return SCM_UNSPECIFIED;
 }
 
+/* Swap the positions of two clients in the list */
 static SCM scm_client_list_swap(SCM client1_smob, SCM client2_smob)
 {
-    client_t *client1 = (client_t *)SCM_SMOB_DATA(client1_smob);
-    client_t *client2 = (client_t *)SCM_SMOB_DATA(client2_smob);
-    rect_t temp_rect;
-    xcb_window_t temp_window;
-    uint16_t temp_border_width;
-
-    temp_rect = client1->rect;
-    temp_window = client1->window;
-    temp_border_width = client1->border_width;
-    client1->rect = client2->rect;
-    client1->window = client2->window;
-    client1->border_width = client2->border_width;
-    client2->rect = temp_rect;
-    client2->window = temp_window;
-    client2->border_width = temp_border_width;
-    
+    client_list_swap(scm_to_client(client1_smob), scm_to_client(client2_smob));
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scm_client_list_move_to_front(SCM client_smob)
+{
+    client_list_move_to_front(scm_to_client(client_smob));
+    return SCM_UNSPECIFIED;
+}
+
+/* Move a client to just before another one in the list */
+static SCM scm_client_list_move_before(SCM client_smob, SCM pos_smob)
+{
+    client_list_move_before(scm_to_client(client_smob), scm_to_client(pos_smob));
+    return SCM_UNSPECIFIED;
+}
+
+/* Move a client to just after another one in the list */
+static SCM scm_client_list_move_after(SCM client_smob, SCM pos_smob)
+{
+    client_list_move_after(scm_to_client(client_smob), scm_to_client(pos_smob));
     return SCM_UNSPECIFIED;
 }
     
 static SCM scm_first_client(void)
 {
     SCM client;
-    SCM_NEWSMOB(client, client_tag, client_list);
+    client = client_to_scm(client_list);
     return client;
 }
 
@@ -249,7 +394,8 @@ static SCM scm_test_undefined(void)
 
 static SCM scm_dump_client(SCM client_smob)
 {
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client_t *client = scm_to_client(client_smob);
+    rect_t rect = client_geometry_rect(client);
 
     SCM out_port = scm_current_output_port();
 
@@ -258,9 +404,8 @@ static SCM scm_dump_client(SCM client_smob)
     const char *fmt = "window: %u\nposition: (%d, %d)\nsize: %u x %u\nborder width: %u\n";
     if ((len = asprintf(&str, fmt, 
                         client->window,
-                        client->rect.x, client->rect.y,
-                        client->rect.width, client->rect.height,
-                        client->border_width)) < 0) {
+                        rect.x, rect.y, rect.width, rect.height,
+                        client_geometry_border_width(client))) < 0) {
         fprintf(stderr, "asprintf failed\n");
         /* not sure what to return here, will figure it out later */
         return SCM_UNSPECIFIED;
@@ -270,6 +415,7 @@ static SCM scm_dump_client(SCM client_smob)
 
     xcb_query_tree_cookie_t c = xcb_query_tree(wm_conf.connection, client->window);
     xcb_query_tree_reply_t *r = xcb_query_tree_reply(wm_conf.connection, c, NULL);
+    ++wm_conf.round_trips;
 
     if ((len = asprintf(&str, "root: %u\nparent: %u\nchildren_len: %u\n",
                         r->root,
@@ -295,7 +441,7 @@ static SCM scm_get_client_name(SCM client_smob)
     SCM scm_name = SCM_UNSPECIFIED;
     if (scm_is_eq(client_smob, SCM_UNSPECIFIED))
         return SCM_UNSPECIFIED;
-    client = (client_t *)SCM_SMOB_DATA(client_smob);
+    client = scm_to_client(client_smob);
     if (!client)
         return SCM_UNSPECIFIED;
     get_client_name(client, name_buf);
@@ -303,12 +449,30 @@ static SCM scm_get_client_name(SCM client_smob)
     return scm_name;
 }
 
+/* The client's WM_CLASS class name, or #f if it has none (yet) */
+static SCM scm_client_class(SCM client_smob)
+{
+    client_t *client = scm_to_client(client_smob);
+    if (!client->props.class)
+        return SCM_BOOL_F;
+    return scm_from_locale_string(client->props.class);
+}
+
+/* The client's WM_CLASS instance name, or #f if it has none (yet) */
+static SCM scm_client_instance(SCM client_smob)
+{
+    client_t *client = scm_to_client(client_smob);
+    if (!client->props.instance)
+        return SCM_BOOL_F;
+    return scm_from_locale_string(client->props.instance);
+}
+
 static SCM scm_get_focus_client(void)
 {
     client_t *focus_client = get_focus_client();
     SCM client_smob = SCM_UNSPECIFIED;
     if (focus_client)
-        SCM_NEWSMOB(client_smob, client_tag, focus_client);
+        client_smob = client_to_scm(focus_client);
 
     return client_smob;
 }
@@ -319,7 +483,7 @@ static SCM scm_focus_client(SCM client_smob)
     if (scm_is_eq(client_smob, SCM_UNSPECIFIED))
         client = client_list;  // Use first client in list if we aren't given a good client_smob
     else
-        client = (client_t *)SCM_SMOB_DATA(client_smob);
+        client = scm_to_client(client_smob);
 
     if (!client)
         return SCM_UNSPECIFIED;
@@ -336,24 +500,16 @@ static SCM scm_next_client(SCM client_smob)
     SCM next_client;
     if (scm_is_eq(client_smob, SCM_UNSPECIFIED))
         return client_smob;
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    if (client->next) {
-        SCM_NEWSMOB(next_client, client_tag, client->next);
-    }
-    else {
-        SCM_NEWSMOB(next_client, client_tag, client_list);
-    }
+    client_t *client = scm_to_client(client_smob);
+    next_client = client_to_scm(client_next(client));
     return next_client;
 }
 
 static SCM scm_prev_client(SCM client_smob)
 {
     SCM prev_client;
-    client_t *client = (client_t *)SCM_SMOB_DATA(client_smob);
-    client_t *cur = client_list;
-    while (cur->next && cur->next != client)
-        cur = cur->next;
-    SCM_NEWSMOB(prev_client, client_tag, cur);
+    client_t *client = scm_to_client(client_smob);
+    prev_client = client_to_scm(client_prev(client));
     return prev_client;
 }
 
@@ -424,6 +580,95 @@ static SCM scm_trace_x_events(SCM status)
     return (wm_conf.trace_x_events ? SCM_BOOL_T : SCM_BOOL_F);
 }
 
+/* Start recording X events to the given file, or stop with #f */
+static SCM scm_record_x_events(SCM path)
+{
+    if (scm_is_false(path))
+        event_record_stop();
+    else if (scm_is_string(path)) {
+        scm_dynwind_begin(0);
+        char *c_path = scm_to_locale_string(path);
+        scm_dynwind_free(c_path);
+        event_record_start(c_path);
+        scm_dynwind_end();
+    }
+    return (event_record_active() ? SCM_BOOL_T : SCM_BOOL_F);
+}
+
+static SCM scm_event_coalesce_stats(void)
+{
+    SCM by_type = SCM_EOL;
+    int type;
+    for (type = 127; type >= 0; --type) {
+        const char *label = xcb_event_get_label(type);
+        if (!event_queue_stats.folded_by_type[type] || !label)
+            continue;
+        by_type = scm_acons(scm_from_locale_symbol(label),
+                            scm_from_ulong(event_queue_stats.folded_by_type[type]),
+                            by_type);
+    }
+    return scm_list_3(scm_cons(scm_from_locale_symbol("received"),
+                               scm_from_ulong(event_queue_stats.received)),
+                      scm_cons(scm_from_locale_symbol("folded"),
+                               scm_from_ulong(event_queue_stats.folded)),
+                      scm_cons(scm_from_locale_symbol("folded-by-type"), by_type));
+}
+
+static SCM event_stats_to_scm(const xcb_event_stats_t *stats)
+{
+    SCM histogram = SCM_EOL;
+    int i;
+    /* (upper bound in ns . count) for each bucket that isn't empty */
+    for (i = XCB_EVENT_LATENCY_BUCKETS - 1; i >= 0; --i) {
+        if (stats->buckets[i])
+            histogram = scm_acons(scm_from_uint64(2ULL << i),
+                                  scm_from_uint64(stats->buckets[i]),
+                                  histogram);
+    }
+    return scm_list_4(scm_cons(scm_from_locale_symbol("count"),
+                               scm_from_uint64(stats->count)),
+                      scm_cons(scm_from_locale_symbol("total-ns"),
+                               scm_from_uint64(stats->total_ns)),
+                      scm_cons(scm_from_locale_symbol("max-ns"),
+                               scm_from_uint64(stats->max_ns)),
+                      scm_cons(scm_from_locale_symbol("histogram"), histogram));
+}
+
+/* Handler count and latency for every event type and error code seen */
+static SCM scm_event_stats(void)
+{
+    SCM events = SCM_EOL;
+    SCM errors = SCM_EOL;
+    const xcb_event_stats_t *stats;
+    const char *label;
+    int i;
+
+    for (i = 127; i >= 0; --i) {
+        stats = xcb_event_get_stats(&wm_conf.event_handlers, i);
+        if (!stats->count)
+            continue;
+        label = xcb_event_get_label(i);
+        events = scm_acons(label ? scm_from_locale_symbol(label) : scm_from_int(i),
+                           event_stats_to_scm(stats), events);
+    }
+    for (i = 255; i >= 0; --i) {
+        stats = xcb_event_get_error_stats(&wm_conf.event_handlers, i);
+        if (!stats->count)
+            continue;
+        label = xcb_event_get_error_label(i);
+        errors = scm_acons(label ? scm_from_locale_symbol(label) : scm_from_int(i),
+                           event_stats_to_scm(stats), errors);
+    }
+    return scm_list_2(scm_cons(scm_from_locale_symbol("events"), events),
+                      scm_cons(scm_from_locale_symbol("errors"), errors));
+}
+
+static SCM scm_event_stats_reset(void)
+{
+    xcb_event_reset_stats(&wm_conf.event_handlers);
+    return SCM_UNSPECIFIED;
+}
+
 void run_hook(const char *hook_name, SCM args)
 {
     SCM hook_symb = scm_from_utf8_symbol(hook_name);
@@ -452,6 +697,9 @@ void *init_scheme(void *data)
     scm_c_define_gsubr("prev-client", 1, 0, 0, &scm_prev_client);
     scm_c_define_gsubr("client-list-reverse", 0, 0, 0, &scm_client_list_reverse);
     scm_c_define_gsubr("client-list-swap", 2, 0, 0, &scm_client_list_swap);
+    scm_c_define_gsubr("client-list-move-to-front", 1, 0, 0, &scm_client_list_move_to_front);
+    scm_c_define_gsubr("client-list-move-before", 2, 0, 0, &scm_client_list_move_before);
+    scm_c_define_gsubr("client-list-move-after", 2, 0, 0, &scm_client_list_move_after);
 
     scm_c_define_gsubr("test-undefined", 0, 0, 0, &scm_test_undefined);
 
@@ -466,6 +714,7 @@ void *init_scheme(void *data)
     scm_c_define_gsubr("client-y", 1, 0, 0, &scm_client_y);
     scm_c_define_gsubr("client-width", 1, 0, 0, &scm_client_width);
     scm_c_define_gsubr("client-height", 1, 0, 0, &scm_client_height);
+    scm_c_define_gsubr("client-border-width", 1, 0, 0, &scm_client_border_width);
 
     scm_c_define_gsubr("screen-width", 0, 0, 0, &scm_screen_width);
     scm_c_define_gsubr("screen-height", 0, 0, 0, &scm_screen_height);
@@ -474,21 +723,37 @@ void *init_scheme(void *data)
 
     scm_c_define_gsubr("clear", 0, 0, 0, &scm_clear);
     scm_c_define_gsubr("draw-border", 3, 0, 0, &scm_draw_border);
+    scm_c_define_gsubr("draw-borders!", 3, 0, 0, &scm_draw_borders_x);
+    scm_c_define_gsubr("border-style", 0, 0, 0, &scm_border_style);
+    scm_c_define_gsubr("set-border-style!", 1, 0, 0, &scm_set_border_style_x);
+    scm_c_define_gsubr("flush", 0, 0, 0, &scm_flush);
+    scm_c_define_gsubr("sync", 0, 0, 0, &scm_sync);
+    scm_c_define_gsubr("x-request-stats", 0, 0, 0, &scm_x_request_stats);
+    scm_c_define_gsubr("atom", 1, 0, 0, &scm_atom);
+    scm_c_define_gsubr("request-layout", 0, 0, 0, &scm_request_layout);
     scm_c_define_gsubr("get-focus-client", 0, 0, 0, &scm_get_focus_client);
     scm_c_define_gsubr("focus-client", 1, 0, 0, &scm_focus_client);
     scm_c_define_gsubr("get-client-name", 1, 0, 0, &scm_get_client_name);
+    scm_c_define_gsubr("client-class", 1, 0, 0, &scm_client_class);
+    scm_c_define_gsubr("client-instance", 1, 0, 0, &scm_client_instance);
 
     scm_c_define_gsubr("launch-program", 1, 0, 0, &scm_launch_program);
 
     scm_c_define_gsubr("log", 1, 0, 0, &scm_nwm_log);
     scm_c_define_gsubr("trace-x-events", 1, 0, 0, &scm_trace_x_events);
+    scm_c_define_gsubr("record-x-events", 1, 0, 0, &scm_record_x_events);
+    scm_c_define_gsubr("event-coalesce-stats", 0, 0, 0, &scm_event_coalesce_stats);
+    scm_c_define_gsubr("event-stats", 0, 0, 0, &scm_event_stats);
+    scm_c_define_gsubr("event-stats-reset", 0, 0, 0, &scm_event_stats_reset);
 
     scm_c_define("create-client-hook", scm_make_hook(scm_from_int(1)));
     scm_c_define("map-client-hook", scm_make_hook(scm_from_int(1)));
     scm_c_define("unmap-client-hook", scm_make_hook(scm_from_int(1)));
     scm_c_define("destroy-client-hook", scm_make_hook(scm_from_int(1)));
     scm_c_define("focus-client-hook", scm_make_hook(scm_from_int(1)));
+    scm_c_define("focus-change-hook", scm_make_hook(scm_from_int(2)));
     scm_c_define("update-client-hook", scm_make_hook(scm_from_int(1)));
+    scm_c_define("layout-hook", scm_make_hook(scm_from_int(0)));
 
     init_client_type();
 
@@ -25,5 +25,8 @@ scm_t_bits client_tag;
 
 void *init_scheme(void *data);
 void run_hook(const char*, SCM);
+SCM client_to_scm(client_t *);
+void client_release_scm(client_t *);
+client_t *scm_to_client(SCM);
 
 #endif
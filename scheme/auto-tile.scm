@@ -22,10 +22,14 @@
 ;;; This file defines procedures for implementing auto-tiling
 
 ;; Back-end window arrangement procedures
-; move and resize a client
+; move and resize a client so that it, including its X border (if it
+; has one), fills the given area
 (define (arrange-client client x y width height)
-  (move-client client x y)
-  (resize-client client width height))
+  (let ((borders (* 2 (client-border-width client))))
+    (move-client client x y)
+    (resize-client client
+                   (max 1 (- width borders))
+                   (max 1 (- height borders)))))
 
 ; create a vertical stack of clients, helper function
 (define (split-vertical-iter clients x width increment cur gap)
@@ -132,58 +136,63 @@
     (set! auto-tile-arrangements (append (cdr auto-tile-arrangements)
                                          (list (car auto-tile-arrangements))))
     (set! auto-tile-arrangement (car auto-tile-arrangements))
-    (auto-tile (visible-clients))))
+    (request-layout)))
 
-; swap the master client with another client
+; swap the master client with another client: the focused one, or the
+; next one if the master is focused
 (define (swap-master)
   (let* ((visible (visible-clients))
          (master (car visible))
-         (focused (get-focus-client)))
-    (if (equal? master focused)
-        (client-list-swap focused (cadr visible))
-        (client-list-swap focused master))
-    (focus-client (car visible))))
+         (focused (get-focus-client))
+         (new-master (if (eq? master focused) (cadr visible) focused)))
+    (client-list-swap new-master master)
+    (focus-client new-master)))
 
 ; add another client to the master area
 (define (add-master)
   (set! master-count (+ master-count 1))
-  (auto-tile (visible-clients)))
+  (request-layout))
 
 ; remove a client from the master area
 (define (remove-master)
   (if (> master-count 1)
       (set! master-count (- master-count 1)))
-  (auto-tile (visible-clients)))
+  (request-layout))
 
 ; grow the master area
 (define (grow-master amount)
   (if (< master-perc (- 100 (+ amount 1)))
       (set! master-perc (+ master-perc amount)))
-  (auto-tile (visible-clients)))
+  (request-layout))
 
 ; shrink the master area
 (define (shrink-master amount)
   (if (>= master-perc (+ amount 1))
       (set! master-perc (- master-perc amount)))
-  (auto-tile (visible-clients)))
+  (request-layout))
 
 ;; Set up hooks
+; the core runs layout-hook once per event loop cycle after something
+; called (request-layout), so a burst of new windows is tiled only once
+(add-hook! layout-hook (lambda ()
+                         (auto-tile (visible-clients))))
+
 ; map-client
 (add-hook! map-client-hook focus-client)
 (add-hook! map-client-hook (lambda (client)
-                             (auto-tile (visible-clients))))
+                             (request-layout)))
 
 ; unmap-client
 (add-hook! unmap-client-hook (lambda (client)
                                (focus-client (next-client client))))
 (add-hook! unmap-client-hook (lambda (client)
-                               (auto-tile (visible-clients))))
+                               (request-layout)))
 
 ; destroy-client
 (add-hook! destroy-client-hook (lambda (client)
                                  (focus-client (next-client client))))
 (add-hook! destroy-client-hook (lambda (client)
-                                 (auto-tile (visible-clients))))
+                                 (request-layout)))
 
 ;; Default keybindings
 ; add a master, mod4-i
@@ -207,4 +216,4 @@
 (bind-key 64 "s" (lambda ()
                    (begin
                      (swap-master)
-                     (auto-tile (visible-clients)))))
+                     (request-layout))))
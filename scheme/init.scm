@@ -36,51 +36,54 @@
 ; (define term-program '("xterm" "-e" "screen"))
 
 ; window borders
+; borders are drawn by the X server on each window; to paint them on the
+; root window behind the clients instead, use:
+; (set-border-style! 'root)
 (define norm-border-color #x2b2b2b)
 (define focus-border-color #x6CA0A3)
 
-(define (draw-norm-borders client-list color)
-  (if (null? client-list)
-      (clear)
-      (begin
-        (draw-norm-borders (cdr client-list) color)
-        (draw-border (car client-list) color border-width))))
-
 (define (draw-focus-border client color)
   (draw-border client color border-width))
 
+; all the unfocused borders are drawn in one batch
 (define (draw-borders client-list norm-color focus-color)
   (let ((focused (get-focus-client)))
-    (begin
-      (draw-norm-borders client-list norm-color)
-      (if (not (unspecified? focused))
-          (draw-focus-border focused focus-color)))))
+    (clear)
+    (draw-borders! (delq focused client-list) norm-color border-width)
+    (if (and (not (unspecified? focused)) (memq focused client-list))
+        (draw-focus-border focused focus-color))))
 
 ; hooks
-; redraw window borders upon focus change
-(add-hook! focus-client-hook (lambda (client)
-                               (draw-borders (visible-clients) norm-border-color
-                                             focus-border-color)))
+; upon focus change, redraw the borders of just the clients that lost and
+; gained the focus (either may be #f); a client that lost it by being
+; hidden gets no border
+(add-hook! focus-change-hook (lambda (old new)
+                               (if (and old (mapped? old))
+                                   (draw-border old norm-border-color border-width))
+                               (if new
+                                   (draw-focus-border new focus-border-color))))
 ; redraw borders upon auto-tiling
 (add-hook! auto-tile-hook (lambda (clients)
                             (draw-borders clients norm-border-color
                                           focus-border-color)))
 
-(define (focus-next)
-  (let ((focused (get-focus-client))
-        (visible (visible-clients)))
+; only fall back to listing the visible clients when nothing has the focus
+(define (focus-first-visible)
+  (let ((visible (visible-clients)))
     (if (not (null? visible))
-        (if (unspecified? focused)
-            (focus-client (car visible))
-            (focus-client (next-client focused))))))
+        (focus-client (car visible)))))
+
+(define (focus-next)
+  (let ((focused (get-focus-client)))
+    (if (unspecified? focused)
+        (focus-first-visible)
+        (focus-client (next-client focused)))))
 
 (define (focus-prev)
-  (let ((focused (get-focus-client))
-        (visible (visible-clients)))
-    (if (not (null? visible))
-        (if (unspecified? focused)
-            (focus-client (car visible))
-            (focus-client (prev-client focused))))))
+  (let ((focused (get-focus-client)))
+    (if (unspecified? focused)
+        (focus-first-visible)
+        (focus-client (prev-client focused)))))
 
 (define (close)
   (destroy-client (get-focus-client)))
@@ -108,7 +111,7 @@
 (bind-key 4 "s" (lambda ()
                    (begin
                      (swap-master)
-                     (auto-tile (visible-clients)))))
+                     (request-layout))))
 
 ; close window, ctrl-shift-c
 (bind-key 5 "c" close)